@@ -0,0 +1,11 @@
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+
+get_filename_component(_xcsp3_converter_lib_dir "${CMAKE_CURRENT_LIST_DIR}/../.." ABSOLUTE)
+if(NOT TARGET xcsp3_converter::xcsp3parser)
+    add_library(xcsp3_converter::xcsp3parser STATIC IMPORTED)
+    set_property(TARGET xcsp3_converter::xcsp3parser PROPERTY IMPORTED_LOCATION ${_xcsp3_converter_lib_dir}/libxcsp3parser.a)
+endif()
+unset(_xcsp3_converter_lib_dir)
+
+include(${CMAKE_CURRENT_LIST_DIR}/xcsp3_converterTargets.cmake)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary CSP format written by `--format binary`.
+//
+// All values are little-endian 32-bit integers ("words"), whatever the byte order of the host.
+//
+//   header:     magic "XCSPBIN\0" (2 words), version, number of variables, number of constraints
+//   variable:   [n_words, type, aux, position, lo, hi, n_values, name_length, values..., name]
+//               `n_words` counts the words after itself. `values` is empty if the domain is the whole
+//               [lo, hi]. `name` is `name_length` bytes padded with zeros to a word boundary.
+//   constraint: [n_words, node]
+//   node:       constant: [kConst | type << 8, value]
+//               variable: [kVar | type << 8, variable index]
+//               operator: [op | type << 8, n_operands, n_operand_words, operands...]
+//
+// `op` and `type` are the values of ir::Op and ir::Type. Variables come in the order of their indices,
+// and constraints in the order of the Sugar output; `position` is the number of constraints
+// preceding the declaration of the variable.
+namespace binary_format {
+
+constexpr char kMagic[8] = {'X', 'C', 'S', 'P', 'B', 'I', 'N', '\0'};
+constexpr int32_t kVersion = 1;
+constexpr int kHeaderWords = 5;
+
+// Converts a word between host order and file order (the conversion is its own inverse)
+inline int32_t LittleEndian(int32_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (int32_t)__builtin_bswap32((uint32_t)word);
+#else
+    return word;
+#endif
+}
+
+}
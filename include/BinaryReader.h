@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "BinaryFormat.h"
+#include "ConverterIR.h"
+
+// Reader of the binary CSP format (see BinaryFormat.h).
+//
+// The file is memory-mapped, and the views below point directly into the mapping, so that iterating
+// over the instance allocates nothing. `Open` checks the fields of every record, so the views do
+// no bounds checking of their own.
+class BinaryReader {
+public:
+    class VariableView {
+    public:
+        explicit VariableView(const int32_t* p) : p_(p) {}
+
+        ir::Type type() const { return (ir::Type)word(1); }
+        bool aux() const { return word(2) != 0; }
+        uint32_t position() const { return word(3); }
+        int lo() const { return word(4); }
+        int hi() const { return word(5); }
+        // Enumerated domain values (sorted); none if the domain is the whole [lo, hi]
+        int num_values() const { return word(6); }
+        int value(int i) const { return word(8 + i); }
+        std::string_view name() const { return std::string_view(reinterpret_cast<const char*>(p_ + 8 + word(6)), word(7)); }
+
+        VariableView Next() const { return VariableView(p_ + 1 + word(0)); }
+
+    private:
+        int32_t word(int i) const { return binary_format::LittleEndian(p_[i]); }
+
+        const int32_t* p_;
+    };
+
+    class NodeView {
+    public:
+        explicit NodeView(const int32_t* p) : p_(p) {}
+
+        ir::Op op() const { return (ir::Op)(word(0) & 0xff); }
+        ir::Type type() const { return (ir::Type)(word(0) >> 8); }
+        bool is_leaf() const { return op() == ir::Op::kConst || op() == ir::Op::kVar; }
+        // kConst: the constant, kVar: the variable index
+        int value() const { return word(1); }
+        int num_operands() const { return is_leaf() ? 0 : word(1); }
+        // Operands are iterated by `FirstOperand()` followed by `Next()`
+        NodeView FirstOperand() const { return NodeView(p_ + 3); }
+        NodeView Next() const { return NodeView(p_ + num_words()); }
+        int num_words() const { return is_leaf() ? 2 : 3 + word(2); }
+
+    private:
+        int32_t word(int i) const { return binary_format::LittleEndian(p_[i]); }
+
+        const int32_t* p_;
+    };
+
+    BinaryReader() = default;
+    ~BinaryReader();
+    BinaryReader(const BinaryReader&) = delete;
+    BinaryReader& operator=(const BinaryReader&) = delete;
+
+    // Returns false and sets `error` if the file cannot be mapped or is not a valid binary CSP file.
+    bool Open(const std::string& path, std::string& error);
+
+    int32_t version() const { return binary_format::LittleEndian(words_[2]); }
+    int num_variables() const { return binary_format::LittleEndian(words_[3]); }
+    int num_constraints() const { return binary_format::LittleEndian(words_[4]); }
+
+    template <class F>
+    void ForEachVariable(F f) const {
+        VariableView var(words_ + binary_format::kHeaderWords);
+        for (int i = 0; i < num_variables(); ++i) {
+            f(var);
+            var = var.Next();
+        }
+    }
+
+    // `f` is called with the root node of each constraint
+    template <class F>
+    void ForEachConstraint(F f) const {
+        const int32_t* p = constraints_;
+        for (int i = 0; i < num_constraints(); ++i) {
+            f(NodeView(p + 1));
+            p += 1 + binary_format::LittleEndian(p[0]);
+        }
+    }
+
+private:
+    void* mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+    const int32_t* words_ = nullptr;
+    const int32_t* constraints_ = nullptr;
+};
@@ -1,14 +1,25 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <XCSP3CoreCallbacks.h>
 
+#include "ConverterIR.h"
+#include "Deduplicator.h"
+#include "Options.h"
 #include "TreeConverter.h"
+#include "XCSP3Converter.h"
 
 class ConverterCallbacks : public XCSP3Core::XCSP3CoreCallbacks {
 public:
+    explicit ConverterCallbacks(const ConverterOptions& options) : options_(options) {
+        if (options_.dedup_constraints) {
+            dedup_ = std::make_unique<Deduplicator>(options_.dedup_max_entries);
+        }
+    }
+
     virtual void buildVariableInteger(std::string id, int minValue, int maxValue) override;
     virtual void buildVariableInteger(std::string id, std::vector<int>& values) override;
     virtual void buildConstraintIntension(std::string id, XCSP3Core::Tree* tree) override;
@@ -28,29 +39,43 @@ public:
     virtual void buildConstraintInstantiation(std::string id, std::vector<XCSP3Core::XVariable *> &list, vector<int> &values) override;
     virtual void buildConstraintElement(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, XCSP3Core::XVariable* value) override;
     virtual void buildConstraintElement(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, int value) override;
-    void buildConstraintElement(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, const std::string& value_desc);
     virtual void buildConstraintElement(std::string id, std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, XCSP3Core::XVariable* value) override;
     virtual void buildConstraintElement(std::string id, std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, int value) override;
-    void buildConstraintElement(std::string id, std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, const std::string& value_desc);
     virtual void buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> values, std::vector<int> &occurs, bool closed) override;
     virtual void buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> values, std::vector<XCSP3Core::XVariable *> &occurs, bool closed) override;
     virtual void buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> values, std::vector<XCSP3Core::XInterval> &occurs, bool closed) override;
-    void buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, const std::vector<std::string>& values_desc, const std::vector<std::string> &occurs_desc, bool closed);
     virtual void buildConstraintExactlyK(std::string id, std::vector<XCSP3Core::XVariable *> &list, int value, int k) override;
     virtual void buildConstraintRegular(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::string start, std::vector<std::string> &final, std::vector<XCSP3Core::XTransition> &transitions) override;
     virtual void buildConstraintCircuit(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex) override;
-    const std::vector<std::string>& GetConvertedDescriptions() const { return converted_; }
+
+    ir::Model& GetModel() { return model_; }
 
 private:
+    ConverterOptions options_;
+    ir::Model model_;
     int n_aux_var_ = 0;
-    std::map<std::string, std::tuple<std::string, Type>> variables_;
-    std::vector<std::string> converted_;
     std::vector<std::vector<int>> last_tuples_;
+    std::unique_ptr<Deduplicator> dedup_;
 
-    std::string VarDescription(const std::string& name, Type type) const;
-    std::string VarDescription(const XCSP3Core::XVariable* var, Type type) const;
+    void AddConstraint(ir::NodeId root);
 
-    std::string NewAuxVarName();
-};
+    void AddElementConstraint(std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, ir::NodeId value);
+    void AddElementConstraint(std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, ir::NodeId value);
 
-std::string ConvertXCSP3Instance(const char* filename);
+    void AddCardinalityConstraint(std::vector<XCSP3Core::XVariable *> &list, const std::vector<int>& values, const std::vector<ir::NodeId> &occurs, bool closed);
+    // Constraints on the number of variables in `list` taking `value`
+    void AddCountConstraint(const std::vector<XCSP3Core::XVariable*>& list, int value, ir::NodeId occurs);
+    void AddCountConstraint(const std::vector<XCSP3Core::XVariable*>& list, int value, int lo, int hi);
+    // Returns the sum of `(if (== x value) 1 0)` over `list`
+    ir::NodeId SumCount(const std::vector<XCSP3Core::XVariable*>& list, int value);
+    // Returns an expression of the count with running-count aux variables, and the number of variables which can take `value`
+    std::tuple<ir::NodeId, int> RunningCount(const std::vector<XCSP3Core::XVariable*>& list, int value);
+    void AddClosedCardinalityConstraint(const std::vector<XCSP3Core::XVariable*>& list, const std::vector<int>& values);
+
+    ir::VarId FindVariable(const std::string& name) const;
+    ir::NodeId VarNode(const std::string& name, ir::Type type);
+    ir::NodeId VarNode(const XCSP3Core::XVariable* var, ir::Type type);
+    ir::NodeId Compare(ir::Op op, ir::NodeId lhs, ir::NodeId rhs) { return model_.Add(op, ir::Type::kBool, {lhs, rhs}); }
+
+    ir::VarId NewAuxVar(int lo, int hi, std::vector<int> values = {});
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Typed intermediate representation of a converted instance.
+//
+// Expressions are stored as a flat array of nodes; operands of a node are a contiguous range of the
+// operand array, and always refer to nodes added before it.
+namespace ir {
+
+using NodeId = int32_t;
+using VarId = int32_t;
+
+enum class Type {
+    kBool, kInt,
+};
+
+enum class Op : uint8_t {
+    kConst,  // integer constant, or true/false for kBool
+    kVar,
+    // integer operations
+    kNeg, kAdd, kSub, kMul, kIf, kAbs,
+    // boolean operations
+    kNot, kAnd, kOr, kXor, kIff, kImp,
+    // comparisons
+    kEq, kNe, kLe, kLt, kGe, kGt,
+    // global constraints
+    kAllDifferent, kCircuit,
+};
+
+struct Node {
+    Op op;
+    Type type;
+    int32_t value;  // kConst: the constant, kVar: the variable, otherwise: the number of operands
+    uint32_t first_operand;  // index in Model::operands()
+};
+
+struct Variable {
+    std::string name;  // XCSP3 id, or a generated name for aux variables
+    Type type;
+    int lo, hi;
+    std::vector<int> values;  // sorted; empty if the domain is the whole [lo, hi]
+    bool aux;
+    uint32_t position;  // number of constraints added before this variable was declared
+};
+
+struct Constraint {
+    NodeId root;  // of type kBool
+};
+
+class Model {
+public:
+    VarId AddVariable(const std::string& name, Type type, int lo, int hi, std::vector<int> values = {}, bool aux = false);
+    // Returns -1 if there is no variable named `name`
+    VarId FindVariable(const std::string& name) const;
+
+    NodeId Const(int value);
+    NodeId BoolConst(bool value);
+    NodeId Var(VarId var);
+    NodeId Add(Op op, Type type, const NodeId* operands, int n_operands);
+    NodeId Add(Op op, Type type, const std::vector<NodeId>& operands) { return Add(op, type, operands.data(), operands.size()); }
+    NodeId Add(Op op, Type type, std::initializer_list<NodeId> operands) { return Add(op, type, operands.begin(), operands.size()); }
+
+    void AddConstraint(NodeId root) { constraints_.push_back({root}); }
+
+    // Conversions between kBool and kInt: `(if e 1 0)` and `(> e 0)`
+    NodeId AsInt(NodeId node);
+    NodeId AsBool(NodeId node);
+    NodeId AsType(NodeId node, Type type) { return type == Type::kBool ? AsBool(node) : AsInt(node); }
+
+    const std::vector<Variable>& variables() const { return variables_; }
+    const std::vector<Node>& nodes() const { return nodes_; }
+    const std::vector<Constraint>& constraints() const { return constraints_; }
+
+    const Variable& variable(VarId var) const { return variables_[var]; }
+    const Node& node(NodeId node) const { return nodes_[node]; }
+    const NodeId* operands(NodeId node) const { return operands_.data() + nodes_[node].first_operand; }
+    int num_operands(NodeId node) const;
+
+    bool DomainContains(VarId var, int value) const;
+    int DomainSize(VarId var) const;
+
+    // Returns whether each variable is referenced by some constraint
+    std::vector<bool> ReferencedVariables() const;
+    // Removes the variables `v` with !keep[v]. The remaining variables are renumbered in order, so they
+    // must not be referenced by any constraint.
+    void RemoveVariables(const std::vector<bool>& keep);
+
+    // Structural hash and equality of the expressions rooted at `a` and `b`
+    uint64_t Hash(NodeId node) const;
+    bool Equal(NodeId a, NodeId b) const;
+
+private:
+    std::vector<Variable> variables_;
+    std::unordered_map<std::string, VarId> variable_ids_;
+    std::vector<NodeId> var_nodes_;  // node of each variable, created on first use
+    std::unordered_map<int, NodeId> const_nodes_;
+    NodeId bool_const_nodes_[2] = {-1, -1};
+    std::vector<Node> nodes_;
+    std::vector<NodeId> operands_;
+    std::vector<Constraint> constraints_;
+};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set of already seen items, identified by their 64-bit hash and an index into the caller's storage.
+// The table starts small and doubles as items are recorded, but never holds more than `max_entries`
+// items; once full, new items are no longer recorded (so that some repeats may be missed), but lookups
+// against recorded ones still work.
+class Deduplicator {
+public:
+    explicit Deduplicator(size_t max_entries) : max_entries_(max_entries) {
+        hashes_.resize(kInitialCapacity, 0);
+        indices_.resize(kInitialCapacity, kEmpty);
+    }
+
+    // Returns true if an item equal to the one with `hash` has been recorded; otherwise records it as
+    // `index` and returns false. `equal(i)` verifies that the recorded item `i` is equal to the new one,
+    // so hash collisions never drop distinct items.
+    template <class Eq>
+    bool FindOrInsert(uint64_t hash, uint32_t index, Eq equal) {
+        size_t mask = hashes_.size() - 1;
+        for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+            if (indices_[pos] == kEmpty) {
+                if (n_entries_ < max_entries_) {
+                    hashes_[pos] = hash;
+                    indices_[pos] = index;
+                    ++n_entries_;
+                    if (n_entries_ * 2 > hashes_.size()) {
+                        Grow();
+                    }
+                }
+                return false;
+            }
+            if (hashes_[pos] == hash && equal(indices_[pos])) {
+                return true;
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t kEmpty = 0xffffffff;
+    static constexpr size_t kInitialCapacity = 16;
+
+    // Doubles the capacity, keeping the load factor at most 1/2
+    void Grow() {
+        std::vector<uint64_t> hashes(hashes_.size() * 2, 0);
+        std::vector<uint32_t> indices(indices_.size() * 2, kEmpty);
+        size_t mask = hashes.size() - 1;
+        for (size_t i = 0; i < hashes_.size(); ++i) {
+            if (indices_[i] == kEmpty) continue;
+            size_t pos = hashes_[i] & mask;
+            while (indices[pos] != kEmpty) pos = (pos + 1) & mask;
+            hashes[pos] = hashes_[i];
+            indices[pos] = indices_[i];
+        }
+        hashes_.swap(hashes);
+        indices_.swap(indices);
+    }
+
+    size_t max_entries_;
+    size_t n_entries_ = 0;
+    std::vector<uint64_t> hashes_;
+    std::vector<uint32_t> indices_;
+};
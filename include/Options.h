@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class CardinalityEncoding {
+    kSum,  // sum of (if (== x v) 1 0) over the whole list
+    kCounter,  // running-count aux variables over the variables which can take the value
+};
+
+enum class OutputFormat {
+    kSugar,  // Sugar/enigma_csp text
+    kBinary,  // see BinaryFormat.h
+    kCnf,  // DIMACS CNF in the order encoding
+};
+
+// Settings of a single conversion. Shared by the command line and server requests.
+struct ConverterOptions {
+    // Rename all variables to short identifiers (`v0`, `v1`, ..., in base 36)
+    bool rename_variables = false;
+    // If non-empty, the map from renamed identifiers to the original XCSP3 ids is written to this file
+    std::string name_map_path;
+    // Skip constraints identical to an already emitted one
+    bool dedup_constraints = false;
+    // Maximum number of constraints remembered for deduplication, bounding its memory usage
+    size_t dedup_max_entries = 1 << 22;
+    // Encoding of Cardinality and ExactlyK
+    CardinalityEncoding cardinality_encoding = CardinalityEncoding::kSum;
+    OutputFormat output_format = OutputFormat::kSugar;
+    // If non-empty, the map for decoding the values of the variables from a model of the CNF is written to this file
+    std::string cnf_map_path;
+    // Number of threads used for producing the output
+    int n_threads = 1;
+    // Drop variables which are not referenced by any constraint
+    bool eliminate_unused = false;
+    // If non-empty, XCSP3 ids listed in this file (one per line) are kept even if unreferenced
+    std::string keep_list_path;
+};
+
+// Parses conversion options from `args`. Returns false and sets `error` on an unknown or malformed option.
+bool ParseConverterOptions(const std::vector<std::string>& args, ConverterOptions& options, std::string& error);
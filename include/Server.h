@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+struct ServerOptions {
+    int n_workers = 0;  // 0: number of hardware threads
+    std::string socket_path;  // empty: serve requests from stdin
+};
+
+// Runs the converter as a long-lived server.
+//
+// Each request is a single line `<input> <output> [options...]`, and is answered with a single line
+// `ok <input> <output> <elapsed ms>` or `error <input> <output> <message>`.
+// Requests are processed concurrently on a worker pool, so replies may come out of order.
+int RunServer(const ServerOptions& options);
@@ -1,22 +1,10 @@
 #pragma once
 
-#include <algorithm>
-#include <string>
-#include <map>
+#include "ConverterIR.h"
 
 namespace XCSP3Core {
     class Tree;
 }
 
-enum Type {
-    kBool, kInt,
-};
-
-using TypedConvertedExpr = std::tuple<std::string, Type>;
-using VariableMap = std::map<std::string, std::tuple<std::string, Type>>;
-
-TypedConvertedExpr AsInt(const TypedConvertedExpr& ty_expr);
-TypedConvertedExpr AsBool(const TypedConvertedExpr& ty_expr);
-TypedConvertedExpr AsType(const TypedConvertedExpr& ty_expr, Type expected_type);
-
-TypedConvertedExpr ConvertTree(const XCSP3Core::Tree* tree, const VariableMap& var_map);
+// Converts `tree` into the IR. Variables are looked up by their XCSP3 ids in `model`.
+ir::NodeId ConvertTree(const XCSP3Core::Tree* tree, ir::Model& model);
@@ -0,0 +1,39 @@
+#pragma once
+
+// Public interface of xcsp3_converter_lib.
+
+#include <ostream>
+#include <string>
+
+#include "ConverterIR.h"
+#include "Options.h"
+
+// Parses the XCSP3 instance `filename` into the IR.
+// Throws std::runtime_error if the instance uses a construct which is not supported.
+ir::Model ConvertXCSP3InstanceToIR(const char* filename, const ConverterOptions& options = ConverterOptions());
+// Removes the variables not referenced by any constraint, except those whose ids are listed in
+// `keep_list_path` (if non-empty). Throws std::runtime_error if the keep list cannot be read.
+void EliminateUnusedVariables(ir::Model& model, const std::string& keep_list_path);
+
+// Writes `model` in the Sugar/enigma_csp format.
+void PrintSugar(const ir::Model& model, const ConverterOptions& options, std::ostream& out);
+// Writes `model` in the binary CSP format (see BinaryFormat.h, and BinaryReader.h for reading it).
+void PrintBinary(const ir::Model& model, const ConverterOptions& options, std::ostream& out);
+// Writes `model` as DIMACS CNF in the order encoding. If `variable_map` is given, the map for decoding the
+// values of the variables is written into it: `int <name> <v_0> <l_0> ... <v_{k-2}> <l_{k-2}> <v_{k-1}>`
+// (the value is the first v_i whose literal l_i is true, or v_{k-1} if there is none) and `bool <name> <l>`.
+// Throws std::runtime_error if a domain is too large or an expression cannot be encoded.
+void PrintCnf(const ir::Model& model, const ConverterOptions& options, std::ostream& out, std::ostream* variable_map = nullptr);
+// Writes `model` in the format given by `options.output_format`.
+void PrintModel(const ir::Model& model, const ConverterOptions& options, std::ostream& out);
+// Writes the map from the renamed identifiers to the original XCSP3 ids (one `<renamed> <original>` pair per line).
+void PrintNameMap(const ir::Model& model, std::ostream& out);
+// Name of `var` in the output
+std::string OutputVariableName(const ir::Model& model, ir::VarId var, const ConverterOptions& options);
+
+// Converts to the Sugar format. If `name_map` is given, the name map is stored into it.
+std::string ConvertXCSP3Instance(const char* filename, const ConverterOptions& options = ConverterOptions(), std::string* name_map = nullptr);
+
+// Converts `input` and writes the result to the file `output` ("-" for stdout).
+// Throws std::runtime_error if the instance is not supported or the output cannot be written.
+void ConvertXCSP3File(const std::string& input, const std::string& output, const ConverterOptions& options);
@@ -0,0 +1,95 @@
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#include "BinaryFormat.h"
+#include "XCSP3Converter.h"
+
+namespace {
+
+void EncodeNode(const ir::Model& model, ir::NodeId root, std::vector<int32_t>& out) {
+    // explicit stack instead of recursion, as expressions can be nested very deeply (e.g. Lex over long lists)
+    struct Frame {
+        ir::NodeId id;
+        int next_operand;
+        size_t size_pos;  // position of n_operand_words, filled when all operands are written
+    };
+    std::vector<Frame> stack;
+    auto enter = [&](ir::NodeId id) {
+        const ir::Node& node = model.node(id);
+        out.push_back(binary_format::LittleEndian((int32_t)node.op | ((int32_t)node.type << 8)));
+        if (node.op == ir::Op::kConst || node.op == ir::Op::kVar) {
+            out.push_back(binary_format::LittleEndian(node.value));
+            return;
+        }
+        out.push_back(binary_format::LittleEndian(model.num_operands(id)));
+        stack.push_back({id, 0, out.size()});
+        out.push_back(0);
+    };
+
+    enter(root);
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next_operand < model.num_operands(frame.id)) {
+            ir::NodeId operand = model.operands(frame.id)[frame.next_operand++];
+            enter(operand);
+            continue;
+        }
+        out[frame.size_pos] = binary_format::LittleEndian(out.size() - frame.size_pos - 1);
+        stack.pop_back();
+    }
+}
+
+void WriteWords(const std::vector<int32_t>& words, std::ostream& out) {
+    out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(int32_t));
+}
+
+}
+
+void PrintBinary(const ir::Model& model, const ConverterOptions& options, std::ostream& out) {
+    const auto& variables = model.variables();
+    const auto& constraints = model.constraints();
+
+    std::vector<int32_t> buf(binary_format::kHeaderWords);
+    memcpy(buf.data(), binary_format::kMagic, sizeof(binary_format::kMagic));
+    buf[2] = binary_format::LittleEndian(binary_format::kVersion);
+    buf[3] = binary_format::LittleEndian(variables.size());
+    buf[4] = binary_format::LittleEndian(constraints.size());
+
+    for (ir::VarId i = 0; i < variables.size(); ++i) {
+        const ir::Variable& var = variables[i];
+        std::string name = OutputVariableName(model, i, options);
+        size_t start = buf.size();
+        buf.push_back(0);
+        buf.push_back(binary_format::LittleEndian((int32_t)var.type));
+        buf.push_back(binary_format::LittleEndian(var.aux ? 1 : 0));
+        buf.push_back(binary_format::LittleEndian(var.position));
+        buf.push_back(binary_format::LittleEndian(var.lo));
+        buf.push_back(binary_format::LittleEndian(var.hi));
+        buf.push_back(binary_format::LittleEndian(var.values.size()));
+        buf.push_back(binary_format::LittleEndian(name.size()));
+        for (int value : var.values) buf.push_back(binary_format::LittleEndian(value));
+        size_t name_pos = buf.size();
+        buf.resize(name_pos + (name.size() + sizeof(int32_t) - 1) / sizeof(int32_t), 0);
+        memcpy(buf.data() + name_pos, name.data(), name.size());
+        buf[start] = binary_format::LittleEndian(buf.size() - start - 1);
+
+        if (buf.size() >= (1 << 14)) {
+            WriteWords(buf, out);
+            buf.clear();
+        }
+    }
+
+    for (auto& constraint : constraints) {
+        size_t start = buf.size();
+        buf.push_back(0);
+        EncodeNode(model, constraint.root, buf);
+        buf[start] = binary_format::LittleEndian(buf.size() - start - 1);
+
+        if (buf.size() >= (1 << 14)) {
+            WriteWords(buf, out);
+            buf.clear();
+        }
+    }
+    WriteWords(buf, out);
+}
@@ -0,0 +1,143 @@
+#include "BinaryReader.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace {
+
+int32_t Word(const int32_t* p, int i) {
+    return binary_format::LittleEndian(p[i]);
+}
+
+bool IsType(int32_t type) {
+    return type == (int32_t)ir::Type::kBool || type == (int32_t)ir::Type::kInt;
+}
+
+// `p` points at the n_words of a record that fits in the file
+bool IsValidVariable(const int32_t* p) {
+    if (Word(p, 0) < 7 || !IsType(Word(p, 1)) || Word(p, 6) < 0 || Word(p, 7) < 0) return false;
+    return 7 + (int64_t)Word(p, 6) + ((int64_t)Word(p, 7) + 3) / 4 <= Word(p, 0);
+}
+
+// Checks that [p, end) holds exactly one node. Operator nodes are walked with an explicit stack,
+// like the encoder, so that deep expressions cannot overflow the call stack.
+bool IsValidNode(const int32_t* p, const int32_t* end, int num_variables) {
+    struct Frame {
+        const int32_t* end;
+        int32_t remaining;  // operands left to check
+    };
+    std::vector<Frame> stack{{end, 1}};
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.remaining == 0) {
+            if (p != frame.end) return false;
+            stack.pop_back();
+            continue;
+        }
+        --frame.remaining;
+        if (frame.end - p < 2) return false;
+        int32_t op = Word(p, 0) & 0xff;
+        if (op > (int32_t)ir::Op::kCircuit || !IsType(Word(p, 0) >> 8)) return false;
+        if (op == (int32_t)ir::Op::kConst) {
+            p += 2;
+        } else if (op == (int32_t)ir::Op::kVar) {
+            if (Word(p, 1) < 0 || Word(p, 1) >= num_variables) return false;
+            p += 2;
+        } else {
+            if (frame.end - p < 3 || Word(p, 1) < 0 || Word(p, 2) < 0 || Word(p, 2) > frame.end - p - 3) return false;
+            const int32_t* operands_end = p + 3 + Word(p, 2);
+            int32_t n_operands = Word(p, 1);
+            p += 3;
+            stack.push_back({operands_end, n_operands});
+        }
+    }
+    return true;
+}
+
+}
+
+BinaryReader::~BinaryReader() {
+    if (mapped_) munmap(mapped_, mapped_size_);
+}
+
+bool BinaryReader::Open(const std::string& path, std::string& error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        error = "cannot stat " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    if (size < binary_format::kHeaderWords * sizeof(int32_t) || size % sizeof(int32_t) != 0) {
+        error = "not a binary CSP file: " + path;
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "cannot map " + path + ": " + strerror(errno);
+        return false;
+    }
+    // the current file stays open until the new one has been validated
+    auto fail = [&](const std::string& message) {
+        error = message;
+        munmap(mapped, size);
+        return false;
+    };
+    const int32_t* words = static_cast<const int32_t*>(mapped);
+    if (memcmp(mapped, binary_format::kMagic, sizeof(binary_format::kMagic)) != 0) {
+        return fail("not a binary CSP file: " + path);
+    }
+    if (Word(words, 2) != binary_format::kVersion) {
+        return fail("unsupported binary CSP version: " + std::to_string(Word(words, 2)));
+    }
+
+    int32_t num_variables = Word(words, 3);
+    int32_t num_constraints = Word(words, 4);
+    if (num_variables < 0 || num_constraints < 0) {
+        return fail("not a binary CSP file: " + path);
+    }
+
+    // check every record, so that the views never read outside of the mapping
+    const int32_t* end = words + size / sizeof(int32_t);
+    const int32_t* p = words + binary_format::kHeaderWords;
+    for (int i = 0; i < num_variables; ++i) {
+        if (p >= end || Word(p, 0) < 0 || Word(p, 0) >= end - p) {
+            return fail("truncated binary CSP file: " + path);
+        }
+        if (!IsValidVariable(p)) {
+            return fail("invalid variable " + std::to_string(i) + " in binary CSP file: " + path);
+        }
+        p += 1 + Word(p, 0);
+    }
+    const int32_t* constraints = p;
+    for (int i = 0; i < num_constraints; ++i) {
+        if (p >= end || Word(p, 0) < 0 || Word(p, 0) >= end - p) {
+            return fail("truncated binary CSP file: " + path);
+        }
+        if (!IsValidNode(p + 1, p + 1 + Word(p, 0), num_variables)) {
+            return fail("invalid constraint " + std::to_string(i) + " in binary CSP file: " + path);
+        }
+        p += 1 + Word(p, 0);
+    }
+
+    if (mapped_) munmap(mapped_, mapped_size_);
+    mapped_ = mapped;
+    mapped_size_ = size;
+    words_ = words;
+    constraints_ = constraints;
+    return true;
+}
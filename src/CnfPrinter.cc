@@ -0,0 +1,998 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "XCSP3Converter.h"
+
+namespace {
+
+constexpr int64_t kMaxDomainSize = 1 << 24;
+// domains of aux variables are enumerated exactly up to this number of combinations, and are intervals otherwise
+constexpr int64_t kMaxEnumeration = 1 << 12;
+constexpr int kClausesPerChunk = 4096;
+
+int64_t FloorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if (a % b != 0 && ((a < 0) != (b < 0))) --q;
+    return q;
+}
+
+int64_t CeilDiv(int64_t a, int64_t b) {
+    return -FloorDiv(-a, b);
+}
+
+struct Term {
+    int var;  // index of IntVar
+    int64_t coef;
+};
+
+// sum of `terms` + `constant`
+struct LinearSum {
+    std::vector<Term> terms;
+    int64_t constant = 0;
+};
+
+// sum of `terms` <= `rhs`
+struct LinearLe {
+    std::vector<Term> terms;
+    int64_t rhs = 0;
+};
+
+// Either a SAT literal (if `sat` != 0) or a linear inequality
+struct Literal {
+    int sat = 0;
+    LinearLe le;
+};
+
+// SAT literals and at most one linear inequality of 2 or 3 terms (`le.terms` is empty if there is none)
+struct Clause {
+    std::vector<int> lits;
+    LinearLe le;
+};
+
+// Integer variable in the order encoding: lits[i] is true iff the value is at most values[i] (i < values.size() - 1)
+struct IntVar {
+    std::vector<int> values;
+    std::vector<int> lits;
+};
+
+Literal Sat(int lit) {
+    Literal ret;
+    ret.sat = lit;
+    return ret;
+}
+
+void Normalize(LinearSum& sum) {
+    std::sort(sum.terms.begin(), sum.terms.end(), [](const Term& a, const Term& b) { return a.var < b.var; });
+    int n = 0;
+    for (int i = 0; i < sum.terms.size(); ++i) {
+        if (n > 0 && sum.terms[n - 1].var == sum.terms[i].var) {
+            sum.terms[n - 1].coef += sum.terms[i].coef;
+        } else {
+            sum.terms[n++] = sum.terms[i];
+        }
+        if (sum.terms[n - 1].coef == 0) --n;
+    }
+    sum.terms.resize(n);
+}
+
+LinearSum Constant(int64_t value) {
+    LinearSum ret;
+    ret.constant = value;
+    return ret;
+}
+
+LinearSum Single(int var) {
+    LinearSum ret;
+    ret.terms.push_back({var, 1});
+    return ret;
+}
+
+// a + scale * b
+LinearSum Combine(const LinearSum& a, const LinearSum& b, int64_t scale) {
+    LinearSum ret = a;
+    for (auto& t : b.terms) {
+        ret.terms.push_back({t.var, t.coef * scale});
+    }
+    ret.constant += b.constant * scale;
+    Normalize(ret);
+    return ret;
+}
+
+LinearSum Scale(const LinearSum& a, int64_t scale) {
+    return Combine(Constant(0), a, scale);
+}
+
+// a - b + offset
+LinearSum Diff(const LinearSum& a, const LinearSum& b, int64_t offset = 0) {
+    LinearSum ret = Combine(a, b, -1);
+    ret.constant += offset;
+    return ret;
+}
+
+// `sum` <= 0
+Literal LinearLit(const LinearSum& sum) {
+    Literal ret;
+    ret.le.terms = sum.terms;
+    ret.le.rhs = -sum.constant;
+    return ret;
+}
+
+Literal Negate(const Literal& lit) {
+    if (lit.sat != 0) {
+        return Sat(-lit.sat);
+    }
+    // !(sum <= rhs) <=> -sum <= -rhs - 1
+    Literal ret;
+    for (auto& t : lit.le.terms) {
+        ret.le.terms.push_back({t.var, -t.coef});
+    }
+    ret.le.rhs = -lit.le.rhs - 1;
+    return ret;
+}
+
+class CnfEncoder {
+public:
+    explicit CnfEncoder(const ir::Model& model) : model_(model) {}
+
+    void Encode();
+    void PrintDimacs(int n_threads, std::ostream& out) const;
+    void PrintVariableMap(const ConverterOptions& options, std::ostream& out) const;
+
+private:
+    const ir::Model& model_;
+    int n_sat_vars_ = 0;
+    int true_lit_ = 0;
+    std::vector<IntVar> int_vars_;
+    std::vector<int> model_vars_;  // IntVar for kInt variables, SAT variable for kBool variables
+    std::vector<Clause> clauses_;
+    std::unordered_map<ir::NodeId, Literal> bool_cache_;
+    std::unordered_map<ir::NodeId, LinearSum> int_cache_;
+    std::map<std::vector<int>, int> and_cache_;
+    std::vector<bool> prepared_;
+
+    int NewSatVar() { return ++n_sat_vars_; }
+    int NewIntVar(std::vector<int> values);
+    int AddIntVar(std::vector<int> values, std::vector<int> lits);
+    std::vector<int> IntervalValues(int64_t lo, int64_t hi) const;
+    std::vector<int> Values(const LinearSum& sum) const;
+
+    int64_t Min(const Term& t) const;
+    int64_t Max(const Term& t) const;
+    int64_t Min(const LinearSum& sum) const;
+    int64_t Max(const LinearSum& sum) const;
+    // SAT literal of `var` <= `value`; may be true_lit_ or -true_lit_
+    int Le(int var, int64_t value) const;
+    int TermLe(const Term& t, int64_t rhs) const;
+    // SAT literal equivalent to `le` if it has at most 1 term, 0 otherwise
+    int SimpleLit(LinearLe& le) const;
+
+    void AddRoot(ir::NodeId id);
+    void AddClause(const std::vector<Literal>& lits);
+    void AddAllDifferent(const std::vector<LinearSum>& terms);
+    void AddCircuit(const std::vector<LinearSum>& terms);
+    LinearLe Split(LinearLe le);
+
+    void PrepareOperands(ir::NodeId id);
+    Literal BoolLit(ir::NodeId id);
+    Literal BoolLitImpl(ir::NodeId id);
+    int ToSat(const Literal& lit);
+    int DefineAnd(const std::vector<Literal>& lits);
+    int DefineOr(const std::vector<Literal>& lits);
+    int DefineIff(int a, int b);
+
+    LinearSum LinearOf(ir::NodeId id);
+    LinearSum NonlinearOf(ir::NodeId id);
+    int ToIntVar(const LinearSum& sum);
+    int Product(int x, int y);
+
+    template<class Emit>
+    void Expand(const Clause& clause, Emit& emit) const;
+    template<class Emit>
+    void ExpandImpl(const LinearLe& le, int i, int64_t rhs, const std::vector<int64_t>& suffix_min, const std::vector<int64_t>& suffix_max, std::vector<int>& lits, Emit& emit) const;
+};
+
+int CnfEncoder::NewIntVar(std::vector<int> values) {
+    std::vector<int> lits;
+    for (int i = 0; i + 1 < values.size(); ++i) {
+        lits.push_back(NewSatVar());
+        if (i > 0) {
+            clauses_.push_back({{-lits[i - 1], lits[i]}, {}});
+        }
+    }
+    return AddIntVar(std::move(values), std::move(lits));
+}
+
+int CnfEncoder::AddIntVar(std::vector<int> values, std::vector<int> lits) {
+    int_vars_.push_back({std::move(values), std::move(lits)});
+    return int_vars_.size() - 1;
+}
+
+std::vector<int> CnfEncoder::IntervalValues(int64_t lo, int64_t hi) const {
+    if (hi - lo + 1 > kMaxDomainSize || lo < INT32_MIN || hi > INT32_MAX) {
+        throw std::runtime_error("domain [" + std::to_string(lo) + ", " + std::to_string(hi) + "] is too large for the CNF encoding");
+    }
+    std::vector<int> values;
+    for (int64_t v = lo; v <= hi; ++v) {
+        values.push_back(v);
+    }
+    return values;
+}
+
+std::vector<int> CnfEncoder::Values(const LinearSum& sum) const {
+    int64_t n_combinations = 1;
+    for (auto& t : sum.terms) {
+        n_combinations *= int_vars_[t.var].values.size();
+        if (n_combinations > kMaxEnumeration) break;
+    }
+    if (sum.terms.size() > 2 || (sum.terms.size() == 2 && n_combinations > kMaxEnumeration)) {
+        return IntervalValues(Min(sum), Max(sum));
+    }
+    std::vector<int64_t> values{sum.constant};
+    for (auto& t : sum.terms) {
+        std::vector<int64_t> next;
+        for (int64_t a : values) {
+            for (int v : int_vars_[t.var].values) {
+                next.push_back(a + t.coef * v);
+            }
+        }
+        values = std::move(next);
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    if (values.front() < INT32_MIN || values.back() > INT32_MAX) {
+        throw std::runtime_error("values out of the int range in the CNF encoding");
+    }
+    return std::vector<int>(values.begin(), values.end());
+}
+
+int64_t CnfEncoder::Min(const Term& t) const {
+    const IntVar& x = int_vars_[t.var];
+    return t.coef > 0 ? t.coef * x.values.front() : t.coef * x.values.back();
+}
+
+int64_t CnfEncoder::Max(const Term& t) const {
+    const IntVar& x = int_vars_[t.var];
+    return t.coef > 0 ? t.coef * x.values.back() : t.coef * x.values.front();
+}
+
+int64_t CnfEncoder::Min(const LinearSum& sum) const {
+    int64_t ret = sum.constant;
+    for (auto& t : sum.terms) ret += Min(t);
+    return ret;
+}
+
+int64_t CnfEncoder::Max(const LinearSum& sum) const {
+    int64_t ret = sum.constant;
+    for (auto& t : sum.terms) ret += Max(t);
+    return ret;
+}
+
+int CnfEncoder::Le(int var, int64_t value) const {
+    const IntVar& x = int_vars_[var];
+    int i = std::upper_bound(x.values.begin(), x.values.end(), value) - x.values.begin() - 1;
+    if (i < 0) return -true_lit_;
+    if (i + 1 >= x.values.size()) return true_lit_;
+    return x.lits[i];
+}
+
+int CnfEncoder::TermLe(const Term& t, int64_t rhs) const {
+    if (t.coef > 0) {
+        return Le(t.var, FloorDiv(rhs, t.coef));
+    } else {
+        // coef * x <= rhs <=> x >= ceil(rhs / coef)
+        return -Le(t.var, CeilDiv(rhs, t.coef) - 1);
+    }
+}
+
+int CnfEncoder::SimpleLit(LinearLe& le) const {
+    if (le.terms.empty()) {
+        return le.rhs >= 0 ? true_lit_ : -true_lit_;
+    }
+    if (le.terms.size() == 1) {
+        return TermLe(le.terms[0], le.rhs);
+    }
+    int64_t g = 0;
+    for (auto& t : le.terms) {
+        g = std::gcd(g, t.coef < 0 ? -t.coef : t.coef);
+    }
+    if (g > 1) {
+        for (auto& t : le.terms) t.coef /= g;
+        le.rhs = FloorDiv(le.rhs, g);
+    }
+    int64_t lo = 0, hi = 0;
+    for (auto& t : le.terms) {
+        lo += Min(t);
+        hi += Max(t);
+    }
+    if (hi <= le.rhs) return true_lit_;
+    if (lo > le.rhs) return -true_lit_;
+    return 0;
+}
+
+void CnfEncoder::Encode() {
+    prepared_.assign(model_.nodes().size(), false);
+    true_lit_ = NewSatVar();
+    clauses_.push_back({{true_lit_}, {}});
+
+    const auto& variables = model_.variables();
+    for (ir::VarId i = 0; i < variables.size(); ++i) {
+        const ir::Variable& var = variables[i];
+        if (var.type == ir::Type::kBool) {
+            int lit = NewSatVar();
+            model_vars_.push_back(lit);
+            if (var.lo == 1) clauses_.push_back({{lit}, {}});
+            if (var.hi == 0) clauses_.push_back({{-lit}, {}});
+        } else {
+            model_vars_.push_back(NewIntVar(var.values.empty() ? IntervalValues(var.lo, var.hi) : var.values));
+        }
+    }
+    for (auto& constraint : model_.constraints()) {
+        AddRoot(constraint.root);
+    }
+}
+
+void CnfEncoder::AddRoot(ir::NodeId id) {
+    const ir::Node& node = model_.node(id);
+    int n_operands = model_.num_operands(id);
+    const ir::NodeId* operands = model_.operands(id);
+    switch (node.op) {
+        case ir::Op::kConst:
+            if (!node.value) {
+                clauses_.push_back({{-true_lit_}, {}});
+            }
+            return;
+        case ir::Op::kAnd:
+            for (int i = 0; i < n_operands; ++i) {
+                AddRoot(operands[i]);
+            }
+            return;
+        case ir::Op::kOr: {
+            std::vector<Literal> lits;
+            for (int i = 0; i < n_operands; ++i) {
+                lits.push_back(BoolLit(operands[i]));
+            }
+            AddClause(lits);
+            return;
+        }
+        case ir::Op::kImp:
+            AddClause({Negate(BoolLit(operands[0])), BoolLit(operands[1])});
+            return;
+        case ir::Op::kEq: {
+            LinearSum first = LinearOf(operands[0]);
+            for (int i = 1; i < n_operands; ++i) {
+                LinearSum other = LinearOf(operands[i]);
+                AddClause({LinearLit(Diff(first, other))});
+                AddClause({LinearLit(Diff(other, first))});
+            }
+            return;
+        }
+        case ir::Op::kAllDifferent:
+        case ir::Op::kCircuit: {
+            std::vector<LinearSum> terms;
+            for (int i = 0; i < n_operands; ++i) {
+                terms.push_back(LinearOf(operands[i]));
+            }
+            if (node.op == ir::Op::kAllDifferent) {
+                AddAllDifferent(terms);
+            } else {
+                AddCircuit(terms);
+            }
+            return;
+        }
+        default:
+            AddClause({BoolLit(id)});
+            return;
+    }
+}
+
+void CnfEncoder::AddClause(const std::vector<Literal>& lits) {
+    Clause clause;
+    std::vector<LinearLe> non_simple;
+    for (auto& lit : lits) {
+        LinearLe le = lit.le;
+        int sat = lit.sat != 0 ? lit.sat : SimpleLit(le);
+        if (sat == true_lit_) return;
+        if (sat == -true_lit_) continue;
+        if (sat != 0) {
+            clause.lits.push_back(sat);
+        } else {
+            non_simple.push_back(std::move(le));
+        }
+    }
+    // only one linear inequality is expanded with the clause; the others are replaced by new variables implying them
+    for (int i = 1; i < non_simple.size(); ++i) {
+        int b = NewSatVar();
+        clause.lits.push_back(b);
+        Literal lit;
+        lit.le = std::move(non_simple[i]);
+        AddClause({Sat(-b), lit});
+    }
+    if (!non_simple.empty()) {
+        clause.le = Split(std::move(non_simple[0]));
+    } else if (clause.lits.empty()) {
+        clause.lits.push_back(-true_lit_);
+    }
+    clauses_.push_back(std::move(clause));
+}
+
+LinearLe CnfEncoder::Split(LinearLe le) {
+    // The number of clauses is the product of the domain sizes of all terms but one,
+    // so sums of more than 3 terms are split into partial sums.
+    while (le.terms.size() > 3) {
+        std::vector<Term> terms;
+        for (int i = 0; i < le.terms.size(); i += 2) {
+            if (i + 1 == le.terms.size()) {
+                terms.push_back(le.terms[i]);
+                continue;
+            }
+            LinearSum partial;
+            partial.terms = {le.terms[i], le.terms[i + 1]};
+            terms.push_back({ToIntVar(partial), 1});
+        }
+        le.terms = std::move(terms);
+    }
+    // the last term is not enumerated in the expansion
+    std::sort(le.terms.begin(), le.terms.end(), [&](const Term& a, const Term& b) {
+        return int_vars_[a.var].values.size() < int_vars_[b.var].values.size();
+    });
+    return le;
+}
+
+void CnfEncoder::AddAllDifferent(const std::vector<LinearSum>& terms) {
+    for (int i = 0; i < terms.size(); ++i) {
+        for (int j = i + 1; j < terms.size(); ++j) {
+            AddClause({LinearLit(Diff(terms[i], terms[j], 1)), LinearLit(Diff(terms[j], terms[i], 1))});
+        }
+    }
+}
+
+void CnfEncoder::AddCircuit(const std::vector<LinearSum>& terms) {
+    // Successors form a single circuit of length at least 2; `x[i] == i` means that i is not on it.
+    // Exactly one node on the circuit is its root, and `rank` increases by 1 along the other edges.
+    int n = terms.size();
+    std::vector<int> succ, rank, root;
+    for (int i = 0; i < n; ++i) {
+        succ.push_back(ToIntVar(terms[i]));
+        rank.push_back(NewIntVar(IntervalValues(0, n - 1)));
+        root.push_back(NewSatVar());
+    }
+    auto ne = [&](int i, int value) -> std::vector<Literal> {
+        return {Sat(Le(succ[i], value - 1)), Sat(-Le(succ[i], value))};
+    };
+    std::vector<Literal> some_root;
+    for (int i = 0; i < n; ++i) {
+        AddClause({Sat(-Le(succ[i], -1))});
+        AddClause({Sat(Le(succ[i], n - 1))});
+        some_root.push_back(Sat(root[i]));
+        std::vector<Literal> root_on_circuit = ne(i, i);
+        root_on_circuit.push_back(Sat(-root[i]));
+        AddClause(root_on_circuit);
+        for (int j = i + 1; j < n; ++j) {
+            AddClause({Sat(-root[i]), Sat(-root[j])});
+        }
+    }
+    AddClause(some_root);
+    std::vector<LinearSum> succ_terms;
+    for (int i = 0; i < n; ++i) {
+        succ_terms.push_back(Single(succ[i]));
+    }
+    AddAllDifferent(succ_terms);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            if (i == j) continue;
+            std::vector<Literal> lits = ne(i, j);
+            lits.push_back(Sat(root[j]));
+            lits.push_back(LinearLit(Diff(Single(rank[i]), Single(rank[j]), 1)));
+            AddClause(lits);
+        }
+    }
+}
+
+// Encodes the subexpressions below `id` bottom-up with an explicit stack, so that encoding `id` finds
+// the results for its operands in the caches instead of recursing as deep as the expression is nested
+// (e.g. Lex over long lists). These subexpressions would be encoded by `id` anyway.
+void CnfEncoder::PrepareOperands(ir::NodeId id) {
+    std::vector<std::pair<ir::NodeId, int>> stack{{id, 0}};
+    while (!stack.empty()) {
+        auto& [node, next] = stack.back();
+        if (next < model_.num_operands(node)) {
+            ir::NodeId operand = model_.operands(node)[next++];
+            if (!prepared_[operand]) {
+                prepared_[operand] = true;
+                stack.push_back({operand, 0});
+            }
+            continue;
+        }
+        ir::NodeId done = node;
+        stack.pop_back();
+        if (done == id) break;
+        const ir::Node& n = model_.node(done);
+        switch (n.op) {
+            case ir::Op::kNot:
+            case ir::Op::kAnd:
+            case ir::Op::kOr:
+            case ir::Op::kImp:
+            case ir::Op::kIff:
+            case ir::Op::kXor:
+            case ir::Op::kEq:
+            case ir::Op::kNe:
+                BoolLit(done);
+                break;
+            case ir::Op::kMul:
+            case ir::Op::kIf:
+            case ir::Op::kAbs:
+                LinearOf(done);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+Literal CnfEncoder::BoolLit(ir::NodeId id) {
+    if (auto found = bool_cache_.find(id); found != bool_cache_.end()) {
+        return found->second;
+    }
+    PrepareOperands(id);
+    Literal ret = BoolLitImpl(id);
+    if (ret.sat != 0) {
+        bool_cache_.insert({id, ret});
+    }
+    return ret;
+}
+
+Literal CnfEncoder::BoolLitImpl(ir::NodeId id) {
+    const ir::Node& node = model_.node(id);
+    int n_operands = model_.num_operands(id);
+    const ir::NodeId* operands = model_.operands(id);
+    std::vector<Literal> children;
+    switch (node.op) {
+        case ir::Op::kAnd:
+        case ir::Op::kOr:
+        case ir::Op::kImp:
+        case ir::Op::kIff:
+        case ir::Op::kXor:
+            for (int i = 0; i < n_operands; ++i) {
+                children.push_back(BoolLit(operands[i]));
+            }
+            break;
+        default:
+            break;
+    }
+
+    switch (node.op) {
+        case ir::Op::kConst:
+            return Sat(node.value ? true_lit_ : -true_lit_);
+        case ir::Op::kVar:
+            return Sat(model_vars_[node.value]);
+        case ir::Op::kNot:
+            return Negate(BoolLit(operands[0]));
+        case ir::Op::kLe:
+            return LinearLit(Diff(LinearOf(operands[0]), LinearOf(operands[1])));
+        case ir::Op::kLt:
+            return LinearLit(Diff(LinearOf(operands[0]), LinearOf(operands[1]), 1));
+        case ir::Op::kGe:
+            return LinearLit(Diff(LinearOf(operands[1]), LinearOf(operands[0])));
+        case ir::Op::kGt:
+            return LinearLit(Diff(LinearOf(operands[1]), LinearOf(operands[0]), 1));
+        case ir::Op::kEq: {
+            LinearSum first = LinearOf(operands[0]);
+            std::vector<Literal> lits;
+            for (int i = 1; i < n_operands; ++i) {
+                LinearSum other = LinearOf(operands[i]);
+                lits.push_back(LinearLit(Diff(first, other)));
+                lits.push_back(LinearLit(Diff(other, first)));
+            }
+            return Sat(DefineAnd(lits));
+        }
+        case ir::Op::kNe: {
+            LinearSum a = LinearOf(operands[0]), b = LinearOf(operands[1]);
+            return Sat(DefineOr({LinearLit(Diff(a, b, 1)), LinearLit(Diff(b, a, 1))}));
+        }
+        case ir::Op::kAnd:
+            return Sat(DefineAnd(children));
+        case ir::Op::kOr:
+            return Sat(DefineOr(children));
+        case ir::Op::kImp:
+            return Sat(DefineOr({Negate(children[0]), children[1]}));
+        case ir::Op::kIff: {
+            std::vector<Literal> eqs;
+            for (int i = 1; i < n_operands; ++i) {
+                eqs.push_back(Sat(DefineIff(ToSat(children[0]), ToSat(children[i]))));
+            }
+            return Sat(DefineAnd(eqs));
+        }
+        case ir::Op::kXor: {
+            int acc = ToSat(children[0]);
+            for (int i = 1; i < n_operands; ++i) {
+                acc = -DefineIff(acc, ToSat(children[i]));
+            }
+            return Sat(acc);
+        }
+        default:
+            throw std::runtime_error("unsupported expression in the CNF encoding (op " + std::to_string((int)node.op) + ")");
+    }
+}
+
+int CnfEncoder::ToSat(const Literal& lit) {
+    if (lit.sat != 0) {
+        return lit.sat;
+    }
+    return DefineAnd({lit});
+}
+
+int CnfEncoder::DefineAnd(const std::vector<Literal>& lits) {
+    std::vector<int> key;
+    for (auto& lit : lits) {
+        LinearLe le = lit.le;
+        int sat = lit.sat != 0 ? lit.sat : SimpleLit(le);
+        if (sat == 0) {
+            key.clear();
+            break;
+        }
+        key.push_back(sat);
+    }
+    bool all_sat = key.size() == lits.size();
+    if (all_sat) {
+        // the conjunction only consists of SAT literals
+        if (std::find(key.begin(), key.end(), -true_lit_) != key.end()) return -true_lit_;
+        key.erase(std::remove(key.begin(), key.end(), true_lit_), key.end());
+        std::sort(key.begin(), key.end());
+        key.erase(std::unique(key.begin(), key.end()), key.end());
+        if (key.empty()) return true_lit_;
+        if (key.size() == 1) return key[0];
+        if (auto found = and_cache_.find(key); found != and_cache_.end()) {
+            return found->second;
+        }
+    }
+
+    int b = NewSatVar();
+    std::vector<Literal> any_false{Sat(b)};
+    for (auto& lit : lits) {
+        AddClause({Sat(-b), lit});
+        any_false.push_back(Negate(lit));
+    }
+    AddClause(any_false);
+    if (all_sat) {
+        and_cache_.insert({key, b});
+    }
+    return b;
+}
+
+int CnfEncoder::DefineOr(const std::vector<Literal>& lits) {
+    std::vector<Literal> negated;
+    for (auto& lit : lits) {
+        negated.push_back(Negate(lit));
+    }
+    return -DefineAnd(negated);
+}
+
+int CnfEncoder::DefineIff(int a, int b) {
+    int r = NewSatVar();
+    clauses_.push_back({{-r, -a, b}, {}});
+    clauses_.push_back({{-r, a, -b}, {}});
+    clauses_.push_back({{r, a, b}, {}});
+    clauses_.push_back({{r, -a, -b}, {}});
+    return r;
+}
+
+LinearSum CnfEncoder::LinearOf(ir::NodeId id) {
+    const ir::Node& node = model_.node(id);
+    int n_operands = model_.num_operands(id);
+    const ir::NodeId* operands = model_.operands(id);
+    if (node.type == ir::Type::kBool) {
+        return NonlinearOf(id);
+    }
+    switch (node.op) {
+        case ir::Op::kConst:
+            return Constant(node.value);
+        case ir::Op::kVar:
+            return Single(model_vars_[node.value]);
+        case ir::Op::kNeg:
+            return Scale(LinearOf(operands[0]), -1);
+        case ir::Op::kAdd: {
+            LinearSum ret;
+            for (int i = 0; i < n_operands; ++i) {
+                LinearSum sum = LinearOf(operands[i]);
+                ret.terms.insert(ret.terms.end(), sum.terms.begin(), sum.terms.end());
+                ret.constant += sum.constant;
+            }
+            Normalize(ret);
+            return ret;
+        }
+        case ir::Op::kSub:
+            return Diff(LinearOf(operands[0]), LinearOf(operands[1]));
+        case ir::Op::kMul:
+        case ir::Op::kIf:
+        case ir::Op::kAbs:
+            return NonlinearOf(id);
+        default:
+            throw std::runtime_error("unsupported expression in the CNF encoding (op " + std::to_string((int)node.op) + ")");
+    }
+}
+
+LinearSum CnfEncoder::NonlinearOf(ir::NodeId id) {
+    if (auto found = int_cache_.find(id); found != int_cache_.end()) {
+        return found->second;
+    }
+    PrepareOperands(id);
+    const ir::Node& node = model_.node(id);
+    int n_operands = model_.num_operands(id);
+    const ir::NodeId* operands = model_.operands(id);
+    LinearSum ret;
+
+    if (node.type == ir::Type::kBool) {
+        // 0/1 variable sharing the literal of the condition: (x <= 0) <=> !cond
+        int lit = ToSat(BoolLit(id));
+        if (lit == true_lit_ || lit == -true_lit_) {
+            ret = Constant(lit == true_lit_ ? 1 : 0);
+        } else {
+            ret = Single(AddIntVar({0, 1}, {-lit}));
+        }
+    } else if (node.op == ir::Op::kMul) {
+        ret = LinearOf(operands[0]);
+        for (int i = 1; i < n_operands; ++i) {
+            LinearSum factor = LinearOf(operands[i]);
+            if (ret.terms.empty()) {
+                ret = Scale(factor, ret.constant);
+            } else if (factor.terms.empty()) {
+                ret = Scale(ret, factor.constant);
+            } else {
+                ret = Single(Product(ToIntVar(ret), ToIntVar(factor)));
+            }
+        }
+    } else if (node.op == ir::Op::kIf) {
+        Literal cond = BoolLit(operands[0]);
+        LinearSum a = LinearOf(operands[1]), b = LinearOf(operands[2]);
+        int lit = cond.sat;
+        if (lit == true_lit_) {
+            ret = a;
+        } else if (lit == -true_lit_) {
+            ret = b;
+        } else if (a.terms.empty() && b.terms.empty()) {
+            if (a.constant == b.constant) {
+                ret = a;
+            } else {
+                lit = ToSat(cond);
+                // (x <= min(a, b)) <=> (cond if a < b)
+                std::vector<int> values{(int)std::min(a.constant, b.constant), (int)std::max(a.constant, b.constant)};
+                ret = Single(AddIntVar(values, {a.constant < b.constant ? lit : -lit}));
+            }
+        } else {
+            std::vector<int> values = Values(a), values_b = Values(b);
+            values.insert(values.end(), values_b.begin(), values_b.end());
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+            LinearSum x = Single(NewIntVar(values));
+            AddClause({Negate(cond), LinearLit(Diff(x, a))});
+            AddClause({Negate(cond), LinearLit(Diff(a, x))});
+            AddClause({cond, LinearLit(Diff(x, b))});
+            AddClause({cond, LinearLit(Diff(b, x))});
+            ret = x;
+        }
+    } else if (node.op == ir::Op::kAbs) {
+        LinearSum a = LinearOf(operands[0]);
+        if (Min(a) >= 0) {
+            ret = a;
+        } else if (Max(a) <= 0) {
+            ret = Scale(a, -1);
+        } else {
+            std::vector<int> values = Values(a);
+            for (auto& v : values) v = std::abs(v);
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+            LinearSum x = Single(NewIntVar(values));
+            LinearSum neg_a = Scale(a, -1);
+            AddClause({LinearLit(Diff(a, x))});
+            AddClause({LinearLit(Diff(neg_a, x))});
+            AddClause({LinearLit(Diff(x, a)), LinearLit(Diff(x, neg_a))});
+            ret = x;
+        }
+    }
+    int_cache_.insert({id, ret});
+    return ret;
+}
+
+int CnfEncoder::ToIntVar(const LinearSum& sum) {
+    if (sum.terms.size() == 1 && sum.terms[0].coef == 1 && sum.constant == 0) {
+        return sum.terms[0].var;
+    }
+    if (sum.terms.empty()) {
+        return AddIntVar({(int)sum.constant}, {});
+    }
+    LinearSum x = Single(NewIntVar(Values(sum)));
+    AddClause({LinearLit(Diff(x, sum))});
+    AddClause({LinearLit(Diff(sum, x))});
+    return x.terms[0].var;
+}
+
+int CnfEncoder::Product(int x, int y) {
+    if (int_vars_[x].values.size() > int_vars_[y].values.size()) {
+        std::swap(x, y);
+    }
+    const std::vector<int>& xs = int_vars_[x].values;
+    const std::vector<int>& ys = int_vars_[y].values;
+    std::vector<int> values;
+    if ((int64_t)xs.size() * ys.size() <= kMaxEnumeration) {
+        LinearSum products;
+        products.terms.push_back({y, 1});
+        for (int a : xs) {
+            products.terms[0].coef = a;
+            std::vector<int> vs = Values(products);
+            values.insert(values.end(), vs.begin(), vs.end());
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    } else {
+        int64_t corners[4] = {(int64_t)xs.front() * ys.front(), (int64_t)xs.front() * ys.back(), (int64_t)xs.back() * ys.front(), (int64_t)xs.back() * ys.back()};
+        values = IntervalValues(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+    }
+    int z = NewIntVar(values);
+
+    // x == v => z == v * y
+    for (int i = 0; i < int_vars_[x].values.size(); ++i) {
+        int v = int_vars_[x].values[i];
+        Literal x_ne_lower = Sat(Le(x, v - 1)), x_ne_upper = Sat(-Le(x, v));
+        LinearSum zs = Single(z), vy = Scale(Single(y), v);
+        AddClause({x_ne_lower, x_ne_upper, LinearLit(Diff(zs, vy))});
+        AddClause({x_ne_lower, x_ne_upper, LinearLit(Diff(vy, zs))});
+    }
+    return z;
+}
+
+template<class Emit>
+void CnfEncoder::Expand(const Clause& clause, Emit& emit) const {
+    std::vector<int> lits = clause.lits;
+    if (clause.le.terms.empty()) {
+        emit(lits);
+        return;
+    }
+    int n = clause.le.terms.size();
+    std::vector<int64_t> suffix_min(n + 1, 0), suffix_max(n + 1, 0);
+    for (int i = n - 1; i >= 0; --i) {
+        suffix_min[i] = suffix_min[i + 1] + Min(clause.le.terms[i]);
+        suffix_max[i] = suffix_max[i + 1] + Max(clause.le.terms[i]);
+    }
+    ExpandImpl(clause.le, 0, clause.le.rhs, suffix_min, suffix_max, lits, emit);
+}
+
+// Emits `lits` || (sum of le.terms[i..] <= rhs), branching on the value of each term but the last:
+// for a positive coefficient, (x >= v) => (rest <= rhs - coef * v) for each v in the domain of x.
+template<class Emit>
+void CnfEncoder::ExpandImpl(const LinearLe& le, int i, int64_t rhs, const std::vector<int64_t>& suffix_min, const std::vector<int64_t>& suffix_max, std::vector<int>& lits, Emit& emit) const {
+    if (rhs >= suffix_max[i]) return;
+    if (rhs < suffix_min[i]) {
+        emit(lits);
+        return;
+    }
+    const Term& t = le.terms[i];
+    if (i + 1 == le.terms.size()) {
+        lits.push_back(TermLe(t, rhs));
+        emit(lits);
+        lits.pop_back();
+        return;
+    }
+    const IntVar& x = int_vars_[t.var];
+    int n_values = x.values.size();
+    for (int k = 0; k < n_values; ++k) {
+        // values in the increasing order of coef * v
+        int idx = t.coef > 0 ? k : n_values - 1 - k;
+        int64_t rest = rhs - t.coef * x.values[idx];
+        // the premise is (x >= v) for a positive coefficient and (x <= v) otherwise
+        bool has_premise = t.coef > 0 ? idx > 0 : idx + 1 < n_values;
+        if (has_premise) {
+            lits.push_back(t.coef > 0 ? x.lits[idx - 1] : -x.lits[idx]);
+        }
+        ExpandImpl(le, i + 1, rest, suffix_min, suffix_max, lits, emit);
+        if (has_premise) {
+            lits.pop_back();
+        }
+        if (rest < suffix_min[i + 1]) {
+            // clauses for the remaining values are subsumed by the one just emitted
+            break;
+        }
+    }
+}
+
+void CnfEncoder::PrintDimacs(int n_threads, std::ostream& out) const {
+    int n_chunks = (clauses_.size() + kClausesPerChunk - 1) / kClausesPerChunk;
+    auto for_each_clause = [&](int chunk, auto& emit) {
+        int end = std::min<int>((chunk + 1) * kClausesPerChunk, clauses_.size());
+        for (int i = chunk * kClausesPerChunk; i < end; ++i) {
+            Expand(clauses_[i], emit);
+        }
+    };
+    auto count_chunk = [&](int chunk, int64_t& count) {
+        auto emit = [&](const std::vector<int>&) { ++count; };
+        for_each_clause(chunk, emit);
+    };
+    auto format_chunk = [&](int chunk, std::string& buf) {
+        auto emit = [&](const std::vector<int>& lits) {
+            for (int lit : lits) {
+                buf += std::to_string(lit);
+                buf.push_back(' ');
+            }
+            buf += "0\n";
+        };
+        for_each_clause(chunk, emit);
+    };
+
+    // The header needs the number of clauses, so clauses are expanded twice: once for counting them, and
+    // once for writing them out.
+    std::vector<int64_t> counts(n_chunks, 0);
+    if (n_threads <= 1) {
+        for (int k = 0; k < n_chunks; ++k) {
+            count_chunk(k, counts[k]);
+        }
+        out << "p cnf " << n_sat_vars_ << ' ' << std::accumulate(counts.begin(), counts.end(), (int64_t)0) << '\n';
+        std::string buf;
+        for (int k = 0; k < n_chunks; ++k) {
+            format_chunk(k, buf);
+            if (buf.size() >= (1 << 16)) {
+                out << buf;
+                buf.clear();
+            }
+        }
+        out << buf;
+        return;
+    }
+
+    ThreadPool pool(n_threads);
+    for (int k = 0; k < n_chunks; ++k) {
+        pool.Submit([&, k]() { count_chunk(k, counts[k]); });
+    }
+    pool.Wait();
+    out << "p cnf " << n_sat_vars_ << ' ' << std::accumulate(counts.begin(), counts.end(), (int64_t)0) << '\n';
+
+    int window = n_threads * 4;
+    std::vector<std::string> bufs(window);
+    for (int start = 0; start < n_chunks; start += window) {
+        int end = std::min(start + window, n_chunks);
+        for (int k = start; k < end; ++k) {
+            pool.Submit([&, k]() { format_chunk(k, bufs[k - start]); });
+        }
+        pool.Wait();
+        for (int k = start; k < end; ++k) {
+            out << bufs[k - start];
+            bufs[k - start].clear();
+        }
+    }
+}
+
+void CnfEncoder::PrintVariableMap(const ConverterOptions& options, std::ostream& out) const {
+    const auto& variables = model_.variables();
+    for (ir::VarId i = 0; i < variables.size(); ++i) {
+        if (variables[i].aux) continue;
+        std::string name = OutputVariableName(model_, i, options);
+        if (variables[i].type == ir::Type::kBool) {
+            out << "bool " << name << ' ' << model_vars_[i] << '\n';
+            continue;
+        }
+        const IntVar& x = int_vars_[model_vars_[i]];
+        out << "int " << name;
+        for (int j = 0; j + 1 < x.values.size(); ++j) {
+            out << ' ' << x.values[j] << ' ' << x.lits[j];
+        }
+        out << ' ' << x.values.back() << '\n';
+    }
+}
+
+}
+
+void PrintCnf(const ir::Model& model, const ConverterOptions& options, std::ostream& out, std::ostream* variable_map) {
+    CnfEncoder encoder(model);
+    encoder.Encode();
+    encoder.PrintDimacs(options.n_threads, out);
+    if (variable_map) {
+        encoder.PrintVariableMap(options, *variable_map);
+    }
+}
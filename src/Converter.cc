@@ -1,28 +1,43 @@
 #include "Converter.h"
 
 #include <algorithm>
+#include <fstream>
 #include <map>
 #include <sstream>
+#include <stdexcept>
 
 #include <XCSP3CoreParser.h>
 
+namespace {
+
+ir::Op ConditionOp(XCSP3Core::OrderType op) {
+    switch (op) {
+        case XCSP3Core::OrderType::EQ:
+            return ir::Op::kEq;
+        case XCSP3Core::OrderType::NE:
+            return ir::Op::kNe;
+        case XCSP3Core::OrderType::GE:
+            return ir::Op::kGe;
+        case XCSP3Core::OrderType::GT:
+            return ir::Op::kGt;
+        case XCSP3Core::OrderType::LE:
+            return ir::Op::kLe;
+        case XCSP3Core::OrderType::LT:
+            return ir::Op::kLt;
+        default:
+            throw std::runtime_error("unsupported order type: " + std::to_string((int)op));
+    }
+}
+
+}
+
 void ConverterCallbacks::buildVariableInteger(std::string id, int minValue, int maxValue) {
     if (0 <= minValue && maxValue <= 1) {
-        // boolean variable
-        std::string var_name = id;
-        variables_.insert({id, {var_name, Type::kBool}});
-        converted_.push_back("(bool " + var_name + ")");
-        if (minValue == 1) {
-            converted_.push_back(var_name);
-        }
-        if (maxValue == 0) {
-            converted_.push_back("(! " + var_name + ")");
-        }
+        // boolean variable (fixed if minValue == maxValue)
+        model_.AddVariable(id, ir::Type::kBool, minValue, maxValue);
     } else {
         // int variable
-        std::string var_name = id;
-        variables_.insert({id, {var_name, Type::kInt}});
-        converted_.push_back("(int " + var_name + " " + std::to_string(minValue) + " " + std::to_string(maxValue) + ")");
+        model_.AddVariable(id, ir::Type::kInt, minValue, maxValue);
     }
 }
 
@@ -32,46 +47,36 @@ void ConverterCallbacks::buildVariableInteger(std::string id, std::vector<int>&
         return;
     }
     if (values.size() == 0) {
-        std::cerr << "empty domain: value " << id << std::endl;
-        abort();
-    }
-    variables_.insert({id, {id, Type::kInt}});
-    std::string desc = "(int " + id + " (";
-    for (int i = 0; i < values.size(); ++i) {
-        if (i != 0) {
-            desc.push_back(' ');
-        }
-        desc += std::to_string(values[i]);
+        throw std::runtime_error("empty domain: value " + id);
     }
-    desc += "))";
-    converted_.push_back(desc);
+    auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+    model_.AddVariable(id, ir::Type::kInt, *lo, *hi, values);
 }
 
 void ConverterCallbacks::buildConstraintIntension(std::string id, XCSP3Core::Tree* tree) {
-    converted_.push_back(std::get<0>(AsBool(ConvertTree(tree, variables_))));
+    AddConstraint(model_.AsBool(ConvertTree(tree, model_)));
 }
 
 void ConverterCallbacks::buildConstraintOrdered(std::string id, std::vector<XCSP3Core::XVariable *> &list, XCSP3Core::OrderType order) {
-    std::string op;
+    ir::Op op;
     switch (order) {
         case XCSP3Core::OrderType::LT:
-            op = "<";
+            op = ir::Op::kLt;
             break;
         case XCSP3Core::OrderType::LE:
-            op = "<=";
+            op = ir::Op::kLe;
             break;
         case XCSP3Core::OrderType::GT:
-            op = ">";
+            op = ir::Op::kGt;
             break;
         case XCSP3Core::OrderType::GE:
-            op = ">=";
+            op = ir::Op::kGe;
             break;
         default:
-            std::cerr << "error: unsupported order type for Ordered: " << order << std::endl;
-            abort();
+            throw std::runtime_error("unsupported order type for Ordered: " + std::to_string((int)order));
     }
     for (int i = 1; i < list.size(); ++i) {
-        converted_.push_back("(" + op + " " + VarDescription(list[i - 1], Type::kInt) + " " + VarDescription(list[i], Type::kInt) + ")");
+        AddConstraint(Compare(op, VarNode(list[i - 1], ir::Type::kInt), VarNode(list[i], ir::Type::kInt)));
     }
 }
 
@@ -90,33 +95,28 @@ void ConverterCallbacks::buildConstraintLex(std::string id, std::vector<std::vec
             std::reverse(lists.begin(), lists.end());
             break;
         default:
-            std::cerr << "error: unsupported order type for Ordered: " << order << std::endl;
-            abort();
+            throw std::runtime_error("unsupported order type for Ordered: " + std::to_string((int)order));
     }
 
     for (int i = 1; i < lists.size(); ++i) {
         if (lists[i - 1].size() != lists[i].size()) {
-            std::cerr << "error: size mismatch" << std::endl;
-            abort();
+            throw std::runtime_error("size mismatch");
         }
-
-        // (|| (< a0 b0) (&& (== a0 b0) ...))
-        std::ostringstream oss;
-        int n_par = 0;
-        for (int j = 0; j < lists[i].size(); ++j) {
-            if (j + 1 == lists[i].size()) {
-                oss << "(" << (order == XCSP3Core::OrderType::LE ? "<=" : "<") << " " << VarDescription(lists[i - 1][j], Type::kInt) << " " << VarDescription(lists[i][j], Type::kInt) << ")";
-            } else {
-                std::string a = VarDescription(lists[i - 1][j], Type::kInt);
-                std::string b = VarDescription(lists[i][j], Type::kInt);
-                oss << "(|| (< " << a << " " << b << ") (&& (== " << a << " " << b << ") ";
-                n_par += 2;
-            }
+        if (lists[i].empty()) {
+            continue;
         }
-        for (int j = 0; j < n_par; ++j) {
-            oss << ')';
+
+        // (|| (< a0 b0) (&& (== a0 b0) ...)), built from the innermost comparison
+        int n = lists[i].size();
+        ir::Op last_op = order == XCSP3Core::OrderType::LE ? ir::Op::kLe : ir::Op::kLt;
+        ir::NodeId expr = Compare(last_op, VarNode(lists[i - 1][n - 1], ir::Type::kInt), VarNode(lists[i][n - 1], ir::Type::kInt));
+        for (int j = n - 2; j >= 0; --j) {
+            ir::NodeId a = VarNode(lists[i - 1][j], ir::Type::kInt);
+            ir::NodeId b = VarNode(lists[i][j], ir::Type::kInt);
+            ir::NodeId rest = model_.Add(ir::Op::kAnd, ir::Type::kBool, {Compare(ir::Op::kEq, a, b), expr});
+            expr = model_.Add(ir::Op::kOr, ir::Type::kBool, {Compare(ir::Op::kLt, a, b), rest});
         }
-        converted_.push_back(oss.str());
+        AddConstraint(expr);
     }
 }
 
@@ -125,13 +125,12 @@ void ConverterCallbacks::buildConstraintLexMatrix(std::string id, std::vector<st
 
     int height = matrix.size();
     if (height == 0) {
-        abort();
+        throw std::runtime_error("empty matrix for LexMatrix");
     }
     int width = matrix[0].size();
     for (int y = 0; y < height; ++y) {
         if (matrix[y].size() != width) {
-            std::cerr << "jagged matrix not supported for LexMatrix" << std::endl;
-            abort();
+            throw std::runtime_error("jagged matrix not supported for LexMatrix");
         }
     }
     std::vector<std::vector<XCSP3Core::XVariable*>> transposed(width);
@@ -144,23 +143,19 @@ void ConverterCallbacks::buildConstraintLexMatrix(std::string id, std::vector<st
 }
 
 void ConverterCallbacks::buildConstraintAlldifferent(std::string id, std::vector<XCSP3Core::XVariable*> &list) {
-    std::string stmt = "(alldifferent";
+    std::vector<ir::NodeId> operands;
     for (auto& var : list) {
-        stmt.push_back(' ');
-        stmt += VarDescription(var, Type::kInt);
+        operands.push_back(VarNode(var, ir::Type::kInt));
     }
-    stmt.push_back(')');
-    converted_.push_back(stmt);
+    AddConstraint(model_.Add(ir::Op::kAllDifferent, ir::Type::kBool, operands));
 }
 
 void ConverterCallbacks::buildConstraintAlldifferent(string id, std::vector<XCSP3Core::Tree*> &list) {
-    std::string stmt = "(alldifferent";
+    std::vector<ir::NodeId> operands;
     for (auto& t : list) {
-        stmt.push_back(' ');
-        stmt += std::get<0>(AsInt(ConvertTree(t, variables_)));
+        operands.push_back(model_.AsInt(ConvertTree(t, model_)));
     }
-    stmt.push_back(')');
-    converted_.push_back(stmt);
+    AddConstraint(model_.Add(ir::Op::kAllDifferent, ir::Type::kBool, operands));
 }
 
 void ConverterCallbacks::buildConstraintAlldifferentMatrix(std::string id, std::vector<std::vector<XCSP3Core::XVariable *>> &matrix) {
@@ -169,8 +164,7 @@ void ConverterCallbacks::buildConstraintAlldifferentMatrix(std::string id, std::
     int n_col = matrix[0].size();
     for (int i = 1; i < n_row; ++i) {
         if (matrix[i].size() != n_col) {
-            std::cerr << "jagged matrix not supported for Alldifferent" << std::endl;
-            abort();
+            throw std::runtime_error("jagged matrix not supported for Alldifferent");
         }
     }
     for (int y = 0; y < n_row; ++y) {
@@ -191,60 +185,28 @@ void ConverterCallbacks::buildConstraintSum(std::string id, std::vector<XCSP3Cor
 
 void ConverterCallbacks::buildConstraintSum(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> &coeffs, XCSP3Core::XCondition &cond) {
     if (!(cond.operandType == XCSP3Core::OperandType::INTEGER || cond.operandType == XCSP3Core::OperandType::VARIABLE)) {
-        std::cerr << "buildConstraintSum supported only for integer operand" << std::endl;
-        abort();
+        throw std::runtime_error("buildConstraintSum supported only for integer operand");
     }
-    std::string desc = "(";
-    switch (cond.op) {
-        case XCSP3Core::OrderType::EQ:
-            desc += "==";
-            break;
-        case XCSP3Core::OrderType::NE:
-            desc += "!=";
-            break;
-        case XCSP3Core::OrderType::GE:
-            desc += ">=";
-            break;
-        case XCSP3Core::OrderType::GT:
-            desc += ">";
-            break;
-        case XCSP3Core::OrderType::LE:
-            desc += "<=";
-            break;
-        case XCSP3Core::OrderType::LT:
-            desc += "<";
-            break;
-        default:
-            std::cerr << "unsupported order type: " << cond.op << std::endl;
-            abort();
-    }
-    desc += " (+";
+    ir::Op op = ConditionOp(cond.op);
+    std::vector<ir::NodeId> terms;
     for (int i = 0; i < list.size(); ++i) {
-        std::string var_desc = VarDescription(list[i], Type::kInt);
+        ir::NodeId var = VarNode(list[i], ir::Type::kInt);
 
         if (coeffs[i] == 1) {
-            desc.push_back(' ');
-            desc += var_desc;
+            terms.push_back(var);
         } else if (coeffs[i] == -1) {
-            desc += " (- ";
-            desc += var_desc;
-            desc.push_back(')');
+            terms.push_back(model_.Add(ir::Op::kNeg, ir::Type::kInt, {var}));
         } else {
-            desc += " (* ";
-            desc += var_desc;
-            desc.push_back(' ');
-            desc += std::to_string(coeffs[i]);
-            desc.push_back(')');
+            terms.push_back(model_.Add(ir::Op::kMul, ir::Type::kInt, {var, model_.Const(coeffs[i])}));
         }
     }
-    desc += ") ";
+    ir::NodeId rhs;
     if (cond.operandType == XCSP3Core::OperandType::INTEGER) {
-        desc += std::to_string(cond.val);
+        rhs = model_.Const(cond.val);
     } else {
-        desc += VarDescription(cond.var, Type::kInt);
+        rhs = VarNode(cond.var, ir::Type::kInt);
     }
-    desc.push_back(')');
-    converted_.push_back(desc);
+    AddConstraint(Compare(op, model_.Add(ir::Op::kAdd, ir::Type::kInt, terms), rhs));
 }
 
 void ConverterCallbacks::buildConstraintSum(std::string id, std::vector<XCSP3Core::Tree *> &trees, XCSP3Core::XCondition &cond) {
@@ -254,60 +216,28 @@ void ConverterCallbacks::buildConstraintSum(std::string id, std::vector<XCSP3Cor
 
 void ConverterCallbacks::buildConstraintSum(std::string id, std::vector<XCSP3Core::Tree *> &trees, std::vector<int> &coefs, XCSP3Core::XCondition &cond) {
     if (!(cond.operandType == XCSP3Core::OperandType::INTEGER || cond.operandType == XCSP3Core::OperandType::VARIABLE)) {
-        std::cerr << "buildConstraintSum supported only for integer operand" << std::endl;
-        abort();
+        throw std::runtime_error("buildConstraintSum supported only for integer operand");
     }
-    std::string desc = "(";
-    switch (cond.op) {
-        case XCSP3Core::OrderType::EQ:
-            desc += "==";
-            break;
-        case XCSP3Core::OrderType::NE:
-            desc += "!=";
-            break;
-        case XCSP3Core::OrderType::GE:
-            desc += ">=";
-            break;
-        case XCSP3Core::OrderType::GT:
-            desc += ">";
-            break;
-        case XCSP3Core::OrderType::LE:
-            desc += "<=";
-            break;
-        case XCSP3Core::OrderType::LT:
-            desc += "<";
-            break;
-        default:
-            std::cerr << "unsupported order type: " << cond.op << std::endl;
-            abort();
-    }
-    desc += " (+";
+    ir::Op op = ConditionOp(cond.op);
+    std::vector<ir::NodeId> terms;
     for (int i = 0; i < trees.size(); ++i) {
-        std::string tree_desc = std::get<0>(AsInt(ConvertTree(trees[i], variables_)));
+        ir::NodeId tree = model_.AsInt(ConvertTree(trees[i], model_));
 
         if (coefs[i] == 1) {
-            desc.push_back(' ');
-            desc += tree_desc;
+            terms.push_back(tree);
         } else if (coefs[i] == -1) {
-            desc += " (- ";
-            desc += tree_desc;
-            desc.push_back(')');
+            terms.push_back(model_.Add(ir::Op::kNeg, ir::Type::kInt, {tree}));
         } else {
-            desc += " (* ";
-            desc += tree_desc;
-            desc.push_back(' ');
-            desc += std::to_string(coefs[i]);
-            desc.push_back(')');
+            terms.push_back(model_.Add(ir::Op::kMul, ir::Type::kInt, {tree, model_.Const(coefs[i])}));
         }
     }
-    desc += ") ";
+    ir::NodeId rhs;
     if (cond.operandType == XCSP3Core::OperandType::INTEGER) {
-        desc += std::to_string(cond.val);
+        rhs = model_.Const(cond.val);
     } else {
-        desc += VarDescription(cond.var, Type::kInt);
+        rhs = VarNode(cond.var, ir::Type::kInt);
     }
-    desc.push_back(')');
-    converted_.push_back(desc);
+    AddConstraint(Compare(op, model_.Add(ir::Op::kAdd, ir::Type::kInt, terms), rhs));
 }
 
 void ConverterCallbacks::buildConstraintExtension(std::string id, std::vector<XCSP3Core::XVariable *> list, std::vector<std::vector<int>> &tuples, bool support, bool hasStar) {
@@ -333,24 +263,26 @@ void ConverterCallbacks::buildConstraintExtensionAs(std::string id, std::vector<
         if (!flg) {
             // tuple (*,*, ...)
             if (!support) {
-                converted_.push_back("false");
+                AddConstraint(model_.BoolConst(false));
             }
             return;
         }
     }
-    std::ostringstream oss;
-    oss << "(" << (support ? "||" : "&&");
+    std::vector<ir::NodeId> vars;
+    for (auto var : list) vars.push_back(VarNode(var, ir::Type::kInt));
+
+    std::vector<ir::NodeId> tuple_exprs;
+    std::vector<ir::NodeId> literals;
     for (auto& tuple : last_tuples_) {
-        oss << " (" << (support ? "&&" : "||");
+        literals.clear();
         for (int i = 0; i < tuple.size(); ++i) {
             if (tuple[i] != STAR) {
-                oss << " (" << (support ? "==" : "!=") << " " << VarDescription(list[i], Type::kInt) << " " << tuple[i] << ")";
+                literals.push_back(Compare(support ? ir::Op::kEq : ir::Op::kNe, vars[i], model_.Const(tuple[i])));
             }
         }
-        oss << ")";
+        tuple_exprs.push_back(model_.Add(support ? ir::Op::kAnd : ir::Op::kOr, ir::Type::kBool, literals));
     }
-    oss << ")";
-    converted_.push_back(oss.str());
+    AddConstraint(model_.Add(support ? ir::Op::kOr : ir::Op::kAnd, ir::Type::kBool, tuple_exprs));
 }
 
 void ConverterCallbacks::buildConstraintInstantiation(std::string id, std::vector<XCSP3Core::XVariable *> &list, vector<int> &values) {
@@ -359,135 +291,100 @@ void ConverterCallbacks::buildConstraintInstantiation(std::string id, std::vecto
             // TODO: is this inference valid?
             values = std::vector<int>(list.size(), values[0]);
         } else {
-            std::cerr << "size mismatch" << std::endl;
-            abort();
+            throw std::runtime_error("size mismatch");
         }
     }
     for (int i = 0; i < list.size(); ++i) {
         int value = values[i];
-        if (auto found = variables_.find(list[i]->id); found != variables_.end()) {
-            auto [name, ty] = found->second;
-            if (ty == Type::kBool) {
-                if (value == 0) {
-                    converted_.push_back("(! " + name + ")");
-                } else if (value == 1) {
-                    converted_.push_back(name);
-                } else {
-                    converted_.push_back("false");
-                }
+        ir::VarId var = FindVariable(list[i]->id);
+        if (model_.variable(var).type == ir::Type::kBool) {
+            if (value == 0) {
+                AddConstraint(model_.Add(ir::Op::kNot, ir::Type::kBool, {model_.Var(var)}));
+            } else if (value == 1) {
+                AddConstraint(model_.Var(var));
             } else {
-                converted_.push_back("(== " + name + " " + std::to_string(value) + ")");
+                AddConstraint(model_.BoolConst(false));
             }
         } else {
-            std::cerr << "error: unknown variable: " << list[i]->id << std::endl;
-            abort();
+            AddConstraint(Compare(ir::Op::kEq, model_.Var(var), model_.Const(value)));
         }
     }
 }
 
 void ConverterCallbacks::buildConstraintElement(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, XCSP3Core::XVariable* value) {
-    buildConstraintElement(id, list, startIndex, index, rank, VarDescription(value, Type::kInt));
+    AddElementConstraint(list, startIndex, index, rank, VarNode(value, ir::Type::kInt));
 }
 
 void ConverterCallbacks::buildConstraintElement(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, int value) {
-    buildConstraintElement(id, list, startIndex, index, rank, std::to_string(value));
+    AddElementConstraint(list, startIndex, index, rank, model_.Const(value));
 }
 
-void ConverterCallbacks::buildConstraintElement(std::string id, std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, const std::string& value_desc) {
+void ConverterCallbacks::AddElementConstraint(std::vector<XCSP3Core::XVariable *> &list, int startIndex, XCSP3Core::XVariable *index, XCSP3Core::RankType rank, ir::NodeId value) {
     if (rank != XCSP3Core::RankType::ANY) {
-        std::cerr << "error: RankType other than ANY is not supported" << std::endl;
-        abort();
+        throw std::runtime_error("RankType other than ANY is not supported");
     }
-    std::ostringstream oss;
-    oss << "(||";
+    ir::NodeId index_node = VarNode(index, ir::Type::kInt);
+    std::vector<ir::NodeId> cases;
     for (int i = 0; i < list.size(); ++i) {
-        oss << " (&& (== " << VarDescription(list[i], Type::kInt) << " " << value_desc
-            << ") (== " << VarDescription(index, Type::kInt) << " " << std::to_string(i + startIndex)
-            << "))";
+        ir::NodeId value_eq = Compare(ir::Op::kEq, VarNode(list[i], ir::Type::kInt), value);
+        ir::NodeId index_eq = Compare(ir::Op::kEq, index_node, model_.Const(i + startIndex));
+        cases.push_back(model_.Add(ir::Op::kAnd, ir::Type::kBool, {value_eq, index_eq}));
     }
-    oss << ")";
-    converted_.push_back(oss.str());
+    AddConstraint(model_.Add(ir::Op::kOr, ir::Type::kBool, cases));
 }
 
 void ConverterCallbacks::buildConstraintElement(std::string id, std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, XCSP3Core::XVariable* value) {
-    buildConstraintElement(id, matrix, startRowIndex, rowIndex, startColIndex, colIndex, VarDescription(value, Type::kInt));
+    AddElementConstraint(matrix, startRowIndex, rowIndex, startColIndex, colIndex, VarNode(value, ir::Type::kInt));
 }
 
 void ConverterCallbacks::buildConstraintElement(std::string id, std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, int value) {
-    buildConstraintElement(id, matrix, startRowIndex, rowIndex, startColIndex, colIndex, std::to_string(value));
+    AddElementConstraint(matrix, startRowIndex, rowIndex, startColIndex, colIndex, model_.Const(value));
 }
 
-void ConverterCallbacks::buildConstraintElement(std::string id, std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, const std::string& value_desc) {
-    std::ostringstream oss;
-    oss << "(||";
+void ConverterCallbacks::AddElementConstraint(std::vector<std::vector<XCSP3Core::XVariable*> > &matrix, int startRowIndex, XCSP3Core::XVariable *rowIndex, int startColIndex, XCSP3Core::XVariable* colIndex, ir::NodeId value) {
+    ir::NodeId row_node = VarNode(rowIndex, ir::Type::kInt);
+    ir::NodeId col_node = VarNode(colIndex, ir::Type::kInt);
+    std::vector<ir::NodeId> cases;
     for (int y = 0; y < matrix.size(); ++y) {
+        ir::NodeId row_eq = Compare(ir::Op::kEq, row_node, model_.Const(y + startRowIndex));
         for (int x = 0; x < matrix[y].size(); ++x) {
-            oss << " (&& (== " << VarDescription(matrix[y][x], Type::kInt) << " " << value_desc
-                << ") (== " << VarDescription(rowIndex, Type::kInt) << " " << std::to_string(y + startRowIndex)
-                << ") (== " << VarDescription(colIndex, Type::kInt) << " " << std::to_string(x + startColIndex)
-                << "))";
+            ir::NodeId value_eq = Compare(ir::Op::kEq, VarNode(matrix[y][x], ir::Type::kInt), value);
+            ir::NodeId col_eq = Compare(ir::Op::kEq, col_node, model_.Const(x + startColIndex));
+            cases.push_back(model_.Add(ir::Op::kAnd, ir::Type::kBool, {value_eq, row_eq, col_eq}));
         }
     }
-    oss << ")";
-    converted_.push_back(oss.str());
+    AddConstraint(model_.Add(ir::Op::kOr, ir::Type::kBool, cases));
 }
 
 void ConverterCallbacks::buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> values, std::vector<int> &occurs, bool closed) {
-    std::vector<std::string> values_desc;
-    for (int i = 0; i < values.size(); ++i) values_desc.push_back(std::to_string(values[i]));
-    std::vector<std::string> occurs_desc;
-    for (int i = 0; i < occurs.size(); ++i) occurs_desc.push_back(std::to_string(occurs[i]));
-    buildConstraintCardinality(id, list, values_desc, occurs_desc, closed);
+    std::vector<ir::NodeId> occurs_nodes;
+    for (int i = 0; i < occurs.size(); ++i) occurs_nodes.push_back(model_.Const(occurs[i]));
+    AddCardinalityConstraint(list, values, occurs_nodes, closed);
 }
 
 void ConverterCallbacks::buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> values, std::vector<XCSP3Core::XVariable *> &occurs, bool closed) {
-    std::vector<std::string> values_desc;
-    for (int i = 0; i < values.size(); ++i) values_desc.push_back(std::to_string(values[i]));
-    std::vector<std::string> occurs_desc;
-    for (int i = 0; i < occurs.size(); ++i) occurs_desc.push_back(VarDescription(occurs[i], Type::kInt));
-    buildConstraintCardinality(id, list, values_desc, occurs_desc, closed);
+    std::vector<ir::NodeId> occurs_nodes;
+    for (int i = 0; i < occurs.size(); ++i) occurs_nodes.push_back(VarNode(occurs[i], ir::Type::kInt));
+    AddCardinalityConstraint(list, values, occurs_nodes, closed);
 }
 
 void ConverterCallbacks::buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::vector<int> values, std::vector<XCSP3Core::XInterval> &occurs, bool closed) {
-    std::vector<std::string> values_desc;
-    for (int i = 0; i < values.size(); ++i) values_desc.push_back(std::to_string(values[i]));
-    std::vector<std::string> occurs_desc;
-    for (int i = 0; i < occurs.size(); ++i) {
-        int lo = occurs[i].min;
-        int hi = occurs[i].max;
-        std::string var_name = NewAuxVarName();
-        converted_.push_back("(int " + var_name + " " + std::to_string(lo) + " " + std::to_string(hi) + ")");
-        occurs_desc.push_back(var_name);
-    }
-    buildConstraintCardinality(id, list, values_desc, occurs_desc, closed);
-}
-
-void ConverterCallbacks::buildConstraintCardinality(std::string id, std::vector<XCSP3Core::XVariable *> &list, const std::vector<std::string>& values_desc, const std::vector<std::string> &occurs_desc, bool closed) {
-    if (closed) {
-        std::cerr << "error: cardinality of closed form not supported" << std::endl;
-        abort();
-    }
-
-    for (int i = 0; i < values_desc.size(); ++i) {
-        std::ostringstream oss;
-        oss << "(== (+";
-        for (int j = 0; j < list.size(); ++j) {
-            oss << " " << "(if (== " << VarDescription(list[j], Type::kInt) << " " << values_desc[i] << ") 1 0)";
-        }
-        oss << ") " << occurs_desc[i] << ")";
-        converted_.push_back(oss.str());
+    if (closed) AddClosedCardinalityConstraint(list, values);
+    for (int i = 0; i < values.size(); ++i) {
+        AddCountConstraint(list, values[i], occurs[i].min, occurs[i].max);
     }
 }
 
-void ConverterCallbacks::buildConstraintExactlyK(std::string id, std::vector<XCSP3Core::XVariable *> &list, int value, int k) {
-    std::ostringstream oss;
-    oss << "(== (+";
+void ConverterCallbacks::AddCardinalityConstraint(std::vector<XCSP3Core::XVariable *> &list, const std::vector<int>& values, const std::vector<ir::NodeId> &occurs, bool closed) {
+    if (closed) AddClosedCardinalityConstraint(list, values);
 
-    for (int i = 0; i < list.size(); ++i) {
-        oss << " " << "(if (== " << VarDescription(list[i], Type::kInt) << " " << value << ") 1 0)";
+    for (int i = 0; i < values.size(); ++i) {
+        AddCountConstraint(list, values[i], occurs[i]);
     }
-    oss << ") " << k << ")";
-    converted_.push_back(oss.str());
+}
+
+void ConverterCallbacks::buildConstraintExactlyK(std::string id, std::vector<XCSP3Core::XVariable *> &list, int value, int k) {
+    AddCountConstraint(list, value, model_.Const(k));
 }
 
 void ConverterCallbacks::buildConstraintRegular(std::string id, std::vector<XCSP3Core::XVariable *> &list, std::string start, std::vector<std::string> &final, std::vector<XCSP3Core::XTransition> &transitions) {
@@ -511,33 +408,29 @@ void ConverterCallbacks::buildConstraintRegular(std::string id, std::vector<XCSP
         trans.push_back({s_id, d_id, t.val});
     }
 
-    std::vector<std::string> states;
-    states.push_back(std::to_string(start_id));
+    std::vector<ir::NodeId> states;
+    states.push_back(model_.Const(start_id));
     for (int i = 0; i < list.size(); ++i) {
-        std::string aux_var = NewAuxVarName();
+        ir::VarId aux_var;
         if (i + 1 == list.size()) {
-            std::ostringstream oss;
-            oss << "(int " << aux_var << " (";
-            for (int j = 0; j < final_id.size(); ++j) {
-                if (j > 0) oss << " ";
-                oss << final_id[j];
-            }
-            oss << "))";
-            converted_.push_back(oss.str());
+            auto [lo, hi] = std::minmax_element(final_id.begin(), final_id.end());
+            aux_var = NewAuxVar(*lo, *hi, final_id);
         } else {
-            converted_.push_back("(int " + aux_var + " 0 " + std::to_string(state_id_map.size() - 1) + ")");
+            aux_var = NewAuxVar(0, state_id_map.size() - 1);
         }
-        states.push_back(aux_var);
+        states.push_back(model_.Var(aux_var));
     }
 
     for (int i = 0; i < list.size(); ++i) {
-        std::ostringstream oss;
-        oss << "(||";
+        ir::NodeId var = VarNode(list[i], ir::Type::kInt);
+        std::vector<ir::NodeId> cases;
         for (auto& [src, dest, value] : trans) {
-            oss << " (&& (== " << states[i] << " " << src << ") (== " << states[i + 1] << " " << dest << ") (== " << VarDescription(list[i], Type::kInt) << " " << value << "))";
+            ir::NodeId src_eq = Compare(ir::Op::kEq, states[i], model_.Const(src));
+            ir::NodeId dest_eq = Compare(ir::Op::kEq, states[i + 1], model_.Const(dest));
+            ir::NodeId value_eq = Compare(ir::Op::kEq, var, model_.Const(value));
+            cases.push_back(model_.Add(ir::Op::kAnd, ir::Type::kBool, {src_eq, dest_eq, value_eq}));
         }
-        oss << ")";
-        converted_.push_back(oss.str());
+        AddConstraint(model_.Add(ir::Op::kOr, ir::Type::kBool, cases));
     }
 }
 
@@ -545,48 +438,242 @@ void ConverterCallbacks::buildConstraintCircuit(std::string id, std::vector<XCSP
     // TODO: startIndex is ignored (random value is given; bug in the parser?)
     /*
     if (startIndex != 0) {
-        std::cerr << "error: startIndex != 0 is not supported for Circuit (" << startIndex << ")" << std::endl;
-        abort();
+        throw std::runtime_error("startIndex != 0 is not supported for Circuit (" + std::to_string((int)startIndex) + ")");
     }
     */
-    std::ostringstream oss;
-    oss << "(circuit";
+    std::vector<ir::NodeId> operands;
     for (int i = 0; i < list.size(); ++i) {
-        oss << " " << VarDescription(list[i], Type::kInt);
+        operands.push_back(VarNode(list[i], ir::Type::kInt));
     }
-    oss << ")";
-    converted_.push_back(oss.str());
+    AddConstraint(model_.Add(ir::Op::kCircuit, ir::Type::kBool, operands));
 }
 
-std::string ConverterCallbacks::VarDescription(const std::string& name, Type type) const {
-    if (auto found = variables_.find(name); found != variables_.end()) {
-        return std::get<0>(AsType(found->second, type));
+void ConverterCallbacks::AddConstraint(ir::NodeId root) {
+    if (dedup_) {
+        const auto& constraints = model_.constraints();
+        bool seen = dedup_->FindOrInsert(model_.Hash(root), constraints.size(), [&](uint32_t i) { return model_.Equal(constraints[i].root, root); });
+        if (seen) return;
+    }
+    model_.AddConstraint(root);
+}
+
+void ConverterCallbacks::AddCountConstraint(const std::vector<XCSP3Core::XVariable*>& list, int value, ir::NodeId occurs) {
+    if (options_.cardinality_encoding == CardinalityEncoding::kSum) {
+        AddConstraint(Compare(ir::Op::kEq, SumCount(list, value), occurs));
+        return;
+    }
+
+    auto [count, n_eligible] = RunningCount(list, value);
+    AddConstraint(Compare(ir::Op::kEq, count, occurs));
+}
+
+void ConverterCallbacks::AddCountConstraint(const std::vector<XCSP3Core::XVariable*>& list, int value, int lo, int hi) {
+    // the count is within [0, n] by construction, so only the bounds of the interval which cut into it are posted
+    bool counter = options_.cardinality_encoding == CardinalityEncoding::kCounter;
+    int n = 0;
+    for (auto var : list) {
+        if (!counter || model_.DomainContains(FindVariable(var->id), value)) ++n;
+    }
+    lo = std::max(lo, 0);
+    hi = std::min(hi, n);
+    if (lo > hi) {
+        AddConstraint(model_.BoolConst(false));
+        return;
+    }
+    if (lo == 0 && hi == n) {
+        return;
+    }
+
+    ir::NodeId count = counter ? std::get<0>(RunningCount(list, value)) : SumCount(list, value);
+    if (lo == hi) {
+        AddConstraint(Compare(ir::Op::kEq, count, model_.Const(lo)));
+        return;
+    }
+    if (lo > 0) AddConstraint(Compare(ir::Op::kLe, model_.Const(lo), count));
+    if (hi < n) AddConstraint(Compare(ir::Op::kLe, count, model_.Const(hi)));
+}
+
+ir::NodeId ConverterCallbacks::SumCount(const std::vector<XCSP3Core::XVariable*>& list, int value) {
+    std::vector<ir::NodeId> terms;
+    for (int i = 0; i < list.size(); ++i) {
+        ir::NodeId eq = Compare(ir::Op::kEq, VarNode(list[i], ir::Type::kInt), model_.Const(value));
+        terms.push_back(model_.AsInt(eq));
+    }
+    return model_.Add(ir::Op::kAdd, ir::Type::kInt, terms);
+}
+
+std::tuple<ir::NodeId, int> ConverterCallbacks::RunningCount(const std::vector<XCSP3Core::XVariable*>& list, int value) {
+    std::vector<ir::NodeId> terms;
+    for (auto var : list) {
+        if (!model_.DomainContains(FindVariable(var->id), value)) continue;
+        terms.push_back(model_.AsInt(Compare(ir::Op::kEq, VarNode(var, ir::Type::kInt), model_.Const(value))));
+    }
+    if (terms.empty()) {
+        return {model_.Const(0), 0};
+    }
+
+    // c_i = c_{i-1} + [x_i == value] with 0 <= c_i <= i + 1; the last step is returned as an expression
+    ir::NodeId count = terms[0];
+    for (int i = 1; i + 1 < terms.size(); ++i) {
+        ir::NodeId var = model_.Var(NewAuxVar(0, i + 1));
+        AddConstraint(Compare(ir::Op::kEq, var, model_.Add(ir::Op::kAdd, ir::Type::kInt, {count, terms[i]})));
+        count = var;
+    }
+    if (terms.size() >= 2) {
+        count = model_.Add(ir::Op::kAdd, ir::Type::kInt, {count, terms.back()});
+    }
+    return {count, (int)terms.size()};
+}
+
+void ConverterCallbacks::AddClosedCardinalityConstraint(const std::vector<XCSP3Core::XVariable*>& list, const std::vector<int>& values) {
+    for (auto var : list) {
+        ir::VarId var_id = FindVariable(var->id);
+        std::vector<int> allowed;
+        for (int v : values) {
+            if (model_.DomainContains(var_id, v)) allowed.push_back(v);
+        }
+        std::sort(allowed.begin(), allowed.end());
+        allowed.erase(std::unique(allowed.begin(), allowed.end()), allowed.end());
+        if (allowed.size() == model_.DomainSize(var_id)) {
+            // already restricted by the domain
+            continue;
+        }
+        std::vector<ir::NodeId> cases;
+        for (int v : allowed) {
+            cases.push_back(Compare(ir::Op::kEq, VarNode(var, ir::Type::kInt), model_.Const(v)));
+        }
+        AddConstraint(allowed.empty() ? model_.BoolConst(false) : model_.Add(ir::Op::kOr, ir::Type::kBool, cases));
+    }
+}
+
+ir::VarId ConverterCallbacks::FindVariable(const std::string& name) const {
+    if (ir::VarId var = model_.FindVariable(name); var >= 0) {
+        return var;
     } else {
-        std::cerr << "error: unknown variable: " << name << std::endl;
-        abort();
+        throw std::runtime_error("unknown variable: " + name);
     }
 }
 
-std::string ConverterCallbacks::VarDescription(const XCSP3Core::XVariable* var, Type type) const {
-    return VarDescription(var->id, type);
+ir::NodeId ConverterCallbacks::VarNode(const std::string& name, ir::Type type) {
+    return model_.AsType(model_.Var(FindVariable(name)), type);
+}
+
+ir::NodeId ConverterCallbacks::VarNode(const XCSP3Core::XVariable* var, ir::Type type) {
+    return VarNode(var->id, type);
+}
+
+ir::VarId ConverterCallbacks::NewAuxVar(int lo, int hi, std::vector<int> values) {
+    std::string name("converter_aux_var_");
+    name += std::to_string(n_aux_var_++);
+    return model_.AddVariable(name, ir::Type::kInt, lo, hi, std::move(values), true);
 }
 
-std::string ConverterCallbacks::NewAuxVarName() {
-    std::string ret("converter_aux_var_");
-    ret += std::to_string(n_aux_var_++);
-    return ret;
+void EliminateUnusedVariables(ir::Model& model, const std::string& keep_list_path) {
+    std::vector<bool> keep = model.ReferencedVariables();
+    if (!keep_list_path.empty()) {
+        std::ifstream ifs(keep_list_path);
+        if (!ifs) {
+            throw std::runtime_error("cannot open keep list file: " + keep_list_path);
+        }
+        std::string name;
+        while (ifs >> name) {
+            ir::VarId var = model.FindVariable(name);
+            if (var >= 0) {
+                keep[var] = true;
+            }
+        }
+    }
+    model.RemoveVariables(keep);
 }
 
-std::string ConvertXCSP3Instance(const char* filename) {
-    ConverterCallbacks cb;
+ir::Model ConvertXCSP3InstanceToIR(const char* filename, const ConverterOptions& options) {
+    ConverterCallbacks cb(options);
     cb.recognizeSpecialIntensionCases = false;
 
     XCSP3Core::XCSP3CoreParser parser(&cb);
     parser.parse(filename);
 
+    ir::Model& model = cb.GetModel();
+    if (options.eliminate_unused) {
+        EliminateUnusedVariables(model, options.keep_list_path);
+    }
+    return std::move(model);
+}
+
+std::string ConvertXCSP3Instance(const char* filename, const ConverterOptions& options, std::string* name_map) {
+    ir::Model model = ConvertXCSP3InstanceToIR(filename, options);
+
     std::ostringstream oss;
-    for (auto& line : cb.GetConvertedDescriptions()) {
-        oss << line << '\n';
+    PrintSugar(model, options, oss);
+    if (name_map) {
+        std::ostringstream name_map_oss;
+        if (options.rename_variables) {
+            PrintNameMap(model, name_map_oss);
+        }
+        *name_map = name_map_oss.str();
     }
     return oss.str();
 }
+
+void PrintModel(const ir::Model& model, const ConverterOptions& options, std::ostream& out) {
+    switch (options.output_format) {
+        case OutputFormat::kSugar:
+            PrintSugar(model, options, out);
+            if (model.variables().empty() && model.constraints().empty()) {
+                out << '\n';
+            }
+            break;
+        case OutputFormat::kBinary:
+            PrintBinary(model, options, out);
+            break;
+        case OutputFormat::kCnf:
+            PrintCnf(model, options, out);
+            break;
+    }
+}
+
+void ConvertXCSP3File(const std::string& input, const std::string& output, const ConverterOptions& options) {
+    ir::Model model = ConvertXCSP3InstanceToIR(input.c_str(), options);
+
+    if (!options.name_map_path.empty()) {
+        std::ofstream ofs(options.name_map_path);
+        PrintNameMap(model, ofs);
+        if (!ofs) {
+            throw std::runtime_error("cannot write name map file: " + options.name_map_path);
+        }
+    }
+
+    std::ofstream cnf_map;
+    if (options.output_format == OutputFormat::kCnf && !options.cnf_map_path.empty()) {
+        cnf_map.open(options.cnf_map_path);
+        if (!cnf_map) {
+            throw std::runtime_error("cannot open CNF map file: " + options.cnf_map_path);
+        }
+    }
+    auto print = [&](std::ostream& out) {
+        if (cnf_map.is_open()) {
+            PrintCnf(model, options, out, &cnf_map);
+            cnf_map.flush();
+            if (!cnf_map) {
+                throw std::runtime_error("cannot write CNF map file: " + options.cnf_map_path);
+            }
+        } else {
+            PrintModel(model, options, out);
+        }
+    };
+
+    if (output == "-") {
+        print(std::cout);
+        std::cout.flush();
+        return;
+    }
+    std::ofstream ofs(output, std::ios::binary);
+    if (!ofs) {
+        throw std::runtime_error("cannot open output file: " + output);
+    }
+    print(ofs);
+    ofs.flush();
+    if (!ofs) {
+        throw std::runtime_error("cannot write output file: " + output);
+    }
+}
@@ -0,0 +1,208 @@
+#include "ConverterIR.h"
+
+#include <algorithm>
+
+namespace ir {
+
+namespace {
+
+uint64_t Mix(uint64_t h, uint64_t v) {
+    const uint64_t kMul = 0x9e3779b97f4a7c15ULL;
+    h = (h ^ v) * kMul;
+    return h ^ (h >> 29);
+}
+
+}
+
+VarId Model::AddVariable(const std::string& name, Type type, int lo, int hi, std::vector<int> values, bool aux) {
+    VarId id = variables_.size();
+    std::sort(values.begin(), values.end());
+    variables_.push_back({name, type, lo, hi, std::move(values), aux, (uint32_t)constraints_.size()});
+    variable_ids_.insert({name, id});
+    var_nodes_.push_back(-1);
+    return id;
+}
+
+VarId Model::FindVariable(const std::string& name) const {
+    if (auto found = variable_ids_.find(name); found != variable_ids_.end()) {
+        return found->second;
+    }
+    return -1;
+}
+
+NodeId Model::Const(int value) {
+    if (auto found = const_nodes_.find(value); found != const_nodes_.end()) {
+        return found->second;
+    }
+    NodeId id = nodes_.size();
+    nodes_.push_back({Op::kConst, Type::kInt, value, 0});
+    const_nodes_.insert({value, id});
+    return id;
+}
+
+NodeId Model::BoolConst(bool value) {
+    if (bool_const_nodes_[value] < 0) {
+        bool_const_nodes_[value] = nodes_.size();
+        nodes_.push_back({Op::kConst, Type::kBool, value ? 1 : 0, 0});
+    }
+    return bool_const_nodes_[value];
+}
+
+NodeId Model::Var(VarId var) {
+    if (var_nodes_[var] < 0) {
+        var_nodes_[var] = nodes_.size();
+        nodes_.push_back({Op::kVar, variables_[var].type, var, 0});
+    }
+    return var_nodes_[var];
+}
+
+NodeId Model::Add(Op op, Type type, const NodeId* operands, int n_operands) {
+    NodeId id = nodes_.size();
+    uint32_t first = operands_.size();
+    if (operands_.data() <= operands && operands < operands_.data() + operands_.size()) {
+        // `operands` would be invalidated by the insertion below
+        std::vector<NodeId> tmp(operands, operands + n_operands);
+        operands_.insert(operands_.end(), tmp.begin(), tmp.end());
+    } else {
+        operands_.insert(operands_.end(), operands, operands + n_operands);
+    }
+    nodes_.push_back({op, type, n_operands, first});
+    return id;
+}
+
+NodeId Model::AsInt(NodeId node) {
+    if (nodes_[node].type == Type::kBool) {
+        return Add(Op::kIf, Type::kInt, {node, Const(1), Const(0)});
+    } else {
+        return node;
+    }
+}
+
+NodeId Model::AsBool(NodeId node) {
+    if (nodes_[node].type == Type::kInt) {
+        return Add(Op::kGt, Type::kBool, {node, Const(0)});
+    } else {
+        return node;
+    }
+}
+
+int Model::num_operands(NodeId node) const {
+    const Node& n = nodes_[node];
+    if (n.op == Op::kConst || n.op == Op::kVar) return 0;
+    return n.value;
+}
+
+bool Model::DomainContains(VarId var, int value) const {
+    const Variable& v = variables_[var];
+    if (v.values.empty()) {
+        return v.lo <= value && value <= v.hi;
+    }
+    return std::binary_search(v.values.begin(), v.values.end(), value);
+}
+
+int Model::DomainSize(VarId var) const {
+    const Variable& v = variables_[var];
+    if (v.values.empty()) {
+        return v.hi - v.lo + 1;
+    }
+    return v.values.size();
+}
+
+std::vector<bool> Model::ReferencedVariables() const {
+    std::vector<bool> referenced(variables_.size(), false);
+    std::vector<bool> visited(nodes_.size(), false);
+    std::vector<NodeId> stack;
+    for (auto& constraint : constraints_) {
+        stack.push_back(constraint.root);
+        while (!stack.empty()) {
+            NodeId id = stack.back();
+            stack.pop_back();
+            if (visited[id]) continue;
+            visited[id] = true;
+            const Node& n = nodes_[id];
+            if (n.op == Op::kVar) {
+                referenced[n.value] = true;
+            }
+            int n_operands = num_operands(id);
+            const NodeId* ops = operands(id);
+            stack.insert(stack.end(), ops, ops + n_operands);
+        }
+    }
+    return referenced;
+}
+
+void Model::RemoveVariables(const std::vector<bool>& keep) {
+    std::vector<VarId> new_id(variables_.size(), -1);
+    VarId n_kept = 0;
+    for (VarId i = 0; i < variables_.size(); ++i) {
+        if (keep[i]) {
+            new_id[i] = n_kept;
+            if (n_kept != i) {
+                variables_[n_kept] = std::move(variables_[i]);
+                var_nodes_[n_kept] = var_nodes_[i];
+            }
+            ++n_kept;
+        } else {
+            variable_ids_.erase(variables_[i].name);
+        }
+    }
+    variables_.resize(n_kept);
+    var_nodes_.resize(n_kept);
+    for (auto& [name, id] : variable_ids_) {
+        id = new_id[id];
+    }
+    for (auto& node : nodes_) {
+        if (node.op == Op::kVar) {
+            node.value = new_id[node.value];  // -1 for the removed ones, which are unreachable from the constraints
+        }
+    }
+}
+
+// Hash and Equal use explicit stacks, as expressions can be nested very deeply (e.g. Lex over long lists).
+
+uint64_t Model::Hash(NodeId node) const {
+    struct Frame {
+        NodeId id;
+        int next_operand;
+        uint64_t hash;
+    };
+    auto start = [&](NodeId id) -> Frame {
+        const Node& n = nodes_[id];
+        return {id, 0, Mix(Mix((uint64_t)n.op, (uint64_t)n.type), (uint32_t)n.value)};
+    };
+
+    std::vector<Frame> stack{start(node)};
+    for (;;) {
+        Frame& frame = stack.back();
+        if (frame.next_operand < num_operands(frame.id)) {
+            NodeId operand = operands(frame.id)[frame.next_operand++];
+            stack.push_back(start(operand));
+            continue;
+        }
+        uint64_t h = frame.hash;
+        stack.pop_back();
+        if (stack.empty()) return h;
+        stack.back().hash = Mix(stack.back().hash, h);
+    }
+}
+
+bool Model::Equal(NodeId a, NodeId b) const {
+    std::vector<std::pair<NodeId, NodeId>> stack{{a, b}};
+    while (!stack.empty()) {
+        auto [x, y] = stack.back();
+        stack.pop_back();
+        if (x == y) continue;
+        const Node& nx = nodes_[x];
+        const Node& ny = nodes_[y];
+        if (nx.op != ny.op || nx.type != ny.type || nx.value != ny.value) return false;
+        int n_operands = num_operands(x);
+        const NodeId* ops_x = operands(x);
+        const NodeId* ops_y = operands(y);
+        for (int i = 0; i < n_operands; ++i) {
+            stack.push_back({ops_x[i], ops_y[i]});
+        }
+    }
+    return true;
+}
+
+}
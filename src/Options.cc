@@ -0,0 +1,94 @@
+#include "Options.h"
+
+#include <cstdlib>
+
+bool ParseConverterOptions(const std::vector<std::string>& args, ConverterOptions& options, std::string& error) {
+    for (int i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--rename") {
+            options.rename_variables = true;
+        } else if (arg == "--name-map") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --name-map";
+                return false;
+            }
+            options.rename_variables = true;
+            options.name_map_path = args[++i];
+        } else if (arg == "--dedup") {
+            options.dedup_constraints = true;
+        } else if (arg == "--dedup-limit") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --dedup-limit";
+                return false;
+            }
+            long long limit = std::atoll(args[++i].c_str());
+            if (limit <= 0) {
+                error = "invalid argument for --dedup-limit: " + args[i];
+                return false;
+            }
+            options.dedup_constraints = true;
+            options.dedup_max_entries = limit;
+        } else if (arg == "--cardinality-encoding") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --cardinality-encoding";
+                return false;
+            }
+            const std::string& encoding = args[++i];
+            if (encoding == "sum") {
+                options.cardinality_encoding = CardinalityEncoding::kSum;
+            } else if (encoding == "counter") {
+                options.cardinality_encoding = CardinalityEncoding::kCounter;
+            } else {
+                error = "unknown cardinality encoding: " + encoding;
+                return false;
+            }
+        } else if (arg == "--format") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --format";
+                return false;
+            }
+            const std::string& format = args[++i];
+            if (format == "sugar") {
+                options.output_format = OutputFormat::kSugar;
+            } else if (format == "binary") {
+                options.output_format = OutputFormat::kBinary;
+            } else if (format == "cnf") {
+                options.output_format = OutputFormat::kCnf;
+            } else {
+                error = "unknown output format: " + format;
+                return false;
+            }
+        } else if (arg == "--cnf-map") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --cnf-map";
+                return false;
+            }
+            options.output_format = OutputFormat::kCnf;
+            options.cnf_map_path = args[++i];
+        } else if (arg == "--threads") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --threads";
+                return false;
+            }
+            int n_threads = std::atoi(args[++i].c_str());
+            if (n_threads <= 0) {
+                error = "invalid argument for --threads: " + args[i];
+                return false;
+            }
+            options.n_threads = n_threads;
+        } else if (arg == "--eliminate-unused") {
+            options.eliminate_unused = true;
+        } else if (arg == "--keep-list") {
+            if (i + 1 == args.size()) {
+                error = "missing argument for --keep-list";
+                return false;
+            }
+            options.eliminate_unused = true;
+            options.keep_list_path = args[++i];
+        } else {
+            error = "unknown option: " + arg;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,217 @@
+#include "Server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <libxml/parser.h>
+
+#include "Options.h"
+#include "XCSP3Converter.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// Destination of replies. Kept alive by pending requests so that a connection is closed only after
+// all of its replies are sent.
+class ReplySink {
+public:
+    explicit ReplySink(int fd) : fd_(fd) {}
+    ~ReplySink() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    void Send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0) {
+            std::cout << line << std::endl;
+            return;
+        }
+        std::string buf = line + "\n";
+        size_t sent = 0;
+        while (sent < buf.size()) {
+            ssize_t n = send(fd_, buf.data() + sent, buf.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;  // the client has gone away
+            sent += n;
+        }
+    }
+
+private:
+    int fd_;
+    std::mutex mutex_;
+};
+
+// Connections being served by their own threads, which submit to the pool. ServeSocket waits for them
+// before returning, so that the pool outlives every connection.
+class ConnectionSet {
+public:
+    void Add(int fd) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fds_.insert(fd);
+    }
+
+    void Remove(int fd) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fds_.erase(fd);
+        if (fds_.empty()) cv_.notify_all();
+    }
+
+    // Stops reading requests from every connection, and waits until their threads are done. The requests
+    // already submitted are still answered.
+    void CloseAll() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (int fd : fds_) shutdown(fd, SHUT_RD);
+        cv_.wait(lock, [this]() { return fds_.empty(); });
+    }
+
+private:
+    std::unordered_set<int> fds_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+void HandleRequest(const std::string& line, ThreadPool& pool, const std::shared_ptr<ReplySink>& sink) {
+    std::istringstream iss(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token) tokens.push_back(token);
+    if (tokens.empty()) return;
+
+    if (tokens.size() < 2) {
+        sink->Send("error " + tokens[0] + " - request must be `<input> <output> [options...]`");
+        return;
+    }
+    std::string input = tokens[0];
+    std::string output = tokens[1];
+    if (output == "-") {
+        // stdout carries the replies in the stdin mode, and is not the client's in the socket mode
+        sink->Send("error " + input + " " + output + " output must be a file in server mode");
+        return;
+    }
+    ConverterOptions options;
+    std::string error;
+    if (!ParseConverterOptions(std::vector<std::string>(tokens.begin() + 2, tokens.end()), options, error)) {
+        sink->Send("error " + input + " " + output + " " + error);
+        return;
+    }
+
+    pool.Submit([input, output, options, sink]() {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            ConvertXCSP3File(input, output, options);
+        } catch (std::exception& e) {
+            sink->Send("error " + input + " " + output + " " + e.what());
+            return;
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        char elapsed_desc[32];
+        snprintf(elapsed_desc, sizeof(elapsed_desc), "%.3f", elapsed);
+        sink->Send("ok " + input + " " + output + " " + elapsed_desc);
+    });
+}
+
+void ServeConnection(int fd, ThreadPool& pool) {
+    auto sink = std::make_shared<ReplySink>(fd);
+    std::string pending;
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        pending.append(buf, n);
+        size_t pos;
+        while ((pos = pending.find('\n')) != std::string::npos) {
+            HandleRequest(pending.substr(0, pos), pool, sink);
+            pending.erase(0, pos + 1);
+        }
+    }
+    if (!pending.empty()) HandleRequest(pending, pool, sink);
+}
+
+int ServeSocket(const std::string& path, ThreadPool& pool) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "error: socket path too long: " << path << std::endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "error: socket: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    unlink(path.c_str());
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 64) < 0) {
+        std::cerr << "error: cannot listen on " << path << ": " << strerror(errno) << std::endl;
+        close(listen_fd);
+        return 1;
+    }
+
+    ConnectionSet connections;
+    bool out_of_fds = false;
+    for (;;) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE) {
+                // many clients at once; retry when some connections have been closed
+                if (!out_of_fds) std::cerr << "warning: accept: " << strerror(errno) << ", retrying" << std::endl;
+                out_of_fds = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            std::cerr << "error: accept: " << strerror(errno) << std::endl;
+            break;
+        }
+        out_of_fds = false;
+        connections.Add(fd);
+        std::thread([fd, &pool, &connections]() {
+            ServeConnection(fd, pool);
+            connections.Remove(fd);
+        }).detach();
+    }
+    close(listen_fd);
+    connections.CloseAll();
+    pool.Wait();
+    return 1;
+}
+
+}
+
+int RunServer(const ServerOptions& options) {
+    // libxml2 must be initialized once from the main thread before parsing from multiple threads
+    xmlInitParser();
+
+    int n_workers = options.n_workers;
+    if (n_workers <= 0) n_workers = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(n_workers);
+
+    if (!options.socket_path.empty()) {
+        return ServeSocket(options.socket_path, pool);
+    }
+
+    auto sink = std::make_shared<ReplySink>(-1);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        HandleRequest(line, pool, sink);
+    }
+    pool.Wait();
+    return 0;
+}
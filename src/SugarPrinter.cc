@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "XCSP3Converter.h"
+
+namespace {
+
+constexpr int kConstraintsPerSegment = 1024;
+constexpr int kOperandsPerSegment = 1024;
+
+struct Segment {
+    int begin, end;  // range of constraints; `end` may be n_constraints + 1 for the trailing declarations
+    int operand_begin, operand_end;  // range of the operands of the constraint `begin`, or -1 for the whole constraints
+};
+
+const char* OpName(ir::Op op) {
+    switch (op) {
+        case ir::Op::kNeg: return "-";
+        case ir::Op::kAdd: return "+";
+        case ir::Op::kSub: return "-";
+        case ir::Op::kMul: return "*";
+        case ir::Op::kIf: return "if";
+        case ir::Op::kAbs: return "abs";
+        case ir::Op::kNot: return "!";
+        case ir::Op::kAnd: return "&&";
+        case ir::Op::kOr: return "||";
+        case ir::Op::kXor: return "xor";
+        case ir::Op::kIff: return "iff";
+        case ir::Op::kImp: return "=>";
+        case ir::Op::kEq: return "==";
+        case ir::Op::kNe: return "!=";
+        case ir::Op::kLe: return "<=";
+        case ir::Op::kLt: return "<";
+        case ir::Op::kGe: return ">=";
+        case ir::Op::kGt: return ">";
+        case ir::Op::kAllDifferent: return "alldifferent";
+        case ir::Op::kCircuit: return "circuit";
+        default: return "?";
+    }
+}
+
+void PrintNode(const ir::Model& model, ir::NodeId root, const std::vector<std::string>& names, std::string& out) {
+    // Expressions such as Lex are nested as deep as their lists are long, so an explicit stack is used
+    // instead of recursion. Each entry is an operator node and the index of its next operand to print.
+    std::vector<std::pair<ir::NodeId, int>> stack;
+    auto enter = [&](ir::NodeId id) {
+        const ir::Node& node = model.node(id);
+        switch (node.op) {
+            case ir::Op::kConst:
+                if (node.type == ir::Type::kBool) {
+                    out += node.value ? "true" : "false";
+                } else {
+                    out += std::to_string(node.value);
+                }
+                return;
+            case ir::Op::kVar:
+                out += names[node.value];
+                return;
+            default:
+                break;
+        }
+        out.push_back('(');
+        out += OpName(node.op);
+        stack.push_back({id, 0});
+    };
+
+    enter(root);
+    while (!stack.empty()) {
+        auto& [id, next] = stack.back();
+        if (next == model.num_operands(id)) {
+            out.push_back(')');
+            stack.pop_back();
+            continue;
+        }
+        ir::NodeId operand = model.operands(id)[next++];
+        out.push_back(' ');
+        enter(operand);
+    }
+}
+
+void PrintDeclaration(const ir::Model& model, ir::VarId id, const std::vector<std::string>& names, std::string& out) {
+    const ir::Variable& var = model.variable(id);
+    const std::string& name = names[id];
+    if (var.type == ir::Type::kBool) {
+        out += "(bool " + name + ")\n";
+        if (var.lo == 1) {
+            out += name + "\n";
+        }
+        if (var.hi == 0) {
+            out += "(! " + name + ")\n";
+        }
+    } else if (var.values.empty()) {
+        out += "(int " + name + " " + std::to_string(var.lo) + " " + std::to_string(var.hi) + ")\n";
+    } else {
+        out += "(int " + name + " (";
+        for (int i = 0; i < var.values.size(); ++i) {
+            if (i != 0) {
+                out.push_back(' ');
+            }
+            out += std::to_string(var.values[i]);
+        }
+        out += "))\n";
+    }
+}
+
+}
+
+std::string OutputVariableName(const ir::Model& model, ir::VarId var, const ConverterOptions& options) {
+    if (!options.rename_variables) {
+        return model.variable(var).name;
+    }
+    // `v` followed by the index in base 36 (no Sugar keyword starts with `v`)
+    static const char kDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    int idx = var;
+    std::string digits;
+    do {
+        digits.push_back(kDigits[idx % 36]);
+        idx /= 36;
+    } while (idx > 0);
+    return "v" + std::string(digits.rbegin(), digits.rend());
+}
+
+void PrintSugar(const ir::Model& model, const ConverterOptions& options, std::ostream& out) {
+    const auto& variables = model.variables();
+    const auto& constraints = model.constraints();
+    int n_constraints = constraints.size();
+    std::vector<std::string> names;
+    for (ir::VarId i = 0; i < variables.size(); ++i) {
+        names.push_back(OutputVariableName(model, i, options));
+    }
+
+    // Declarations are placed where they were added relative to the constraints:
+    // variables with position `i` are printed right before the constraint `i`.
+    auto print_declarations = [&](int i, std::string& buf) {
+        auto it = std::lower_bound(variables.begin(), variables.end(), (uint32_t)i, [](const ir::Variable& v, uint32_t p) { return v.position < p; });
+        for (ir::VarId v = it - variables.begin(); v < variables.size() && variables[v].position == i; ++v) {
+            PrintDeclaration(model, v, names, buf);
+        }
+    };
+
+    // The output is split into segments which are formatted independently (possibly in parallel) and
+    // written in order. A segment is either a run of constraints, or a range of the operands of a
+    // single constraint with a huge number of operands (tuples of Extension, cases of Element, ...).
+    std::vector<Segment> segments;
+    int run_begin = 0;
+    for (int i = 0; i <= n_constraints; ++i) {
+        int n_operands = i < n_constraints ? model.num_operands(constraints[i].root) : 0;
+        if (i == n_constraints || i - run_begin >= kConstraintsPerSegment || n_operands >= kOperandsPerSegment * 2) {
+            if (run_begin < i) segments.push_back({run_begin, i, -1, -1});
+            run_begin = i;
+        }
+        if (i < n_constraints && n_operands >= kOperandsPerSegment * 2) {
+            for (int j = 0; j < n_operands; j += kOperandsPerSegment) {
+                segments.push_back({i, i + 1, j, std::min(j + kOperandsPerSegment, n_operands)});
+            }
+            run_begin = i + 1;
+        }
+    }
+    // trailing declarations
+    segments.push_back({n_constraints, n_constraints + 1, -1, -1});
+
+    auto format_segment = [&](const Segment& seg, std::string& buf) {
+        if (seg.operand_begin < 0) {
+            for (int i = seg.begin; i < seg.end; ++i) {
+                print_declarations(i, buf);
+                if (i < n_constraints) {
+                    PrintNode(model, constraints[i].root, names, buf);
+                    buf.push_back('\n');
+                }
+            }
+            return;
+        }
+        ir::NodeId root = constraints[seg.begin].root;
+        if (seg.operand_begin == 0) {
+            print_declarations(seg.begin, buf);
+            buf.push_back('(');
+            buf += OpName(model.node(root).op);
+        }
+        const ir::NodeId* operands = model.operands(root);
+        for (int j = seg.operand_begin; j < seg.operand_end; ++j) {
+            buf.push_back(' ');
+            PrintNode(model, operands[j], names, buf);
+        }
+        if (seg.operand_end == model.num_operands(root)) {
+            buf += ")\n";
+        }
+    };
+
+    if (options.n_threads <= 1) {
+        std::string buf;
+        for (auto& seg : segments) {
+            format_segment(seg, buf);
+            if (buf.size() >= (1 << 16)) {
+                out << buf;
+                buf.clear();
+            }
+        }
+        out << buf;
+        return;
+    }
+
+    // format a bounded window of segments at a time to keep the memory usage bounded
+    ThreadPool pool(options.n_threads);
+    int window = options.n_threads * 4;
+    std::vector<std::string> bufs(window);
+    for (int start = 0; start < segments.size(); start += window) {
+        int end = std::min<int>(start + window, segments.size());
+        for (int k = start; k < end; ++k) {
+            pool.Submit([&, k]() { format_segment(segments[k], bufs[k - start]); });
+        }
+        pool.Wait();
+        for (int k = start; k < end; ++k) {
+            out << bufs[k - start];
+            bufs[k - start].clear();
+        }
+    }
+}
+
+void PrintNameMap(const ir::Model& model, std::ostream& out) {
+    ConverterOptions options;
+    options.rename_variables = true;
+    const auto& variables = model.variables();
+    for (ir::VarId i = 0; i < variables.size(); ++i) {
+        if (variables[i].aux) continue;
+        out << OutputVariableName(model, i, options) << ' ' << variables[i].name << '\n';
+    }
+}
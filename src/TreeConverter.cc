@@ -1,7 +1,7 @@
 #include "TreeConverter.h"
 
-#include <cstdlib>
-#include <iostream>
+#include <stdexcept>
+#include <string>
 
 #include <XCSP3Tree.h>
 #include <XCSP3TreeNode.h>
@@ -10,164 +10,116 @@ namespace {
 
 using XCSP3Core::ExpressionType;
 
-std::tuple<std::string, std::vector<Type>, Type> OperatorInfo(ExpressionType type, int n_arity) {
+std::tuple<ir::Op, std::vector<ir::Type>, ir::Type> OperatorInfo(ExpressionType type, int n_arity) {
     switch (type) {
         case ExpressionType::ONEG:
             if (n_arity != 1) {
-                std::cerr << "error: n_arity must be 1 for neg" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 1 for neg");
             }
-            return {"-", {Type::kInt}, Type::kInt};
+            return {ir::Op::kNeg, {ir::Type::kInt}, ir::Type::kInt};
         case ExpressionType::OADD:
-            return {"+", std::vector<Type>(n_arity, Type::kInt), Type::kInt};
+            return {ir::Op::kAdd, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kInt};
         case ExpressionType::OMUL:
-            return {"*", std::vector<Type>(n_arity, Type::kInt), Type::kInt};
+            return {ir::Op::kMul, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kInt};
         case ExpressionType::OSUB:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for sub" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for sub");
             }
-            return {"-", std::vector<Type>(n_arity, Type::kInt), Type::kInt};
+            return {ir::Op::kSub, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kInt};
         case ExpressionType::OIF:
             if (n_arity != 3) {
-                std::cerr << "error: n_arity must be 3 for if" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 3 for if");
             }
-            return {"if", {Type::kBool, Type::kInt, Type::kInt}, Type::kInt};
+            return {ir::Op::kIf, {ir::Type::kBool, ir::Type::kInt, ir::Type::kInt}, ir::Type::kInt};
         case ExpressionType::OABS:
             if (n_arity != 1) {
-                std::cerr << "error: n_arity must be 1 for abs" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 1 for abs");
             }
-            return {"abs", {Type::kInt}, Type::kInt};
+            return {ir::Op::kAbs, {ir::Type::kInt}, ir::Type::kInt};
         case ExpressionType::OAND:
-            return {"and", std::vector<Type>(n_arity, Type::kBool), Type::kBool};
+            return {ir::Op::kAnd, std::vector<ir::Type>(n_arity, ir::Type::kBool), ir::Type::kBool};
         case ExpressionType::OOR:
-            return {"or", std::vector<Type>(n_arity, Type::kBool), Type::kBool};
+            return {ir::Op::kOr, std::vector<ir::Type>(n_arity, ir::Type::kBool), ir::Type::kBool};
         case ExpressionType::OXOR:
-            return {"xor", std::vector<Type>(n_arity, Type::kBool), Type::kBool};
+            return {ir::Op::kXor, std::vector<ir::Type>(n_arity, ir::Type::kBool), ir::Type::kBool};
         case ExpressionType::OIFF:
-            return {"iff", std::vector<Type>(n_arity, Type::kBool), Type::kBool};
+            return {ir::Op::kIff, std::vector<ir::Type>(n_arity, ir::Type::kBool), ir::Type::kBool};
         case ExpressionType::OIMP:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for imp" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for imp");
             }
-            return {"=>", std::vector<Type>(n_arity, Type::kBool), Type::kBool};
+            return {ir::Op::kImp, std::vector<ir::Type>(n_arity, ir::Type::kBool), ir::Type::kBool};
         case ExpressionType::OEQ:
             if (n_arity < 2) {
-                std::cerr << "error: n_arity must be at least 2 for eq" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be at least 2 for eq");
             }
-            return {"==", std::vector<Type>(n_arity, Type::kInt), Type::kBool};
+            return {ir::Op::kEq, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kBool};
         case ExpressionType::ONE:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for ne" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for ne");
             }
-            return {"!=", std::vector<Type>(n_arity, Type::kInt), Type::kBool};
+            return {ir::Op::kNe, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kBool};
         case ExpressionType::OLE:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for le" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for le");
             }
-            return {"<=", std::vector<Type>(n_arity, Type::kInt), Type::kBool};
+            return {ir::Op::kLe, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kBool};
         case ExpressionType::OLT:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for lt" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for lt");
             }
-            return {"<", std::vector<Type>(n_arity, Type::kInt), Type::kBool};
+            return {ir::Op::kLt, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kBool};
         case ExpressionType::OGE:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for ge" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for ge");
             }
-            return {">=", std::vector<Type>(n_arity, Type::kInt), Type::kBool};
+            return {ir::Op::kGe, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kBool};
         case ExpressionType::OGT:
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for gt" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for gt");
             }
-            return {">", std::vector<Type>(n_arity, Type::kInt), Type::kBool};
+            return {ir::Op::kGt, std::vector<ir::Type>(n_arity, ir::Type::kInt), ir::Type::kBool};
         default:
-            std::cerr << "error: unknown operator type: " << type << " (" << XCSP3Core::operatorToString(type) << ")" << std::endl;
-            abort();
+            throw std::runtime_error("unknown operator type: " + std::to_string((int)type) + " (" + XCSP3Core::operatorToString(type) + ")");
     }
 }
 
-TypedConvertedExpr ConvertTreeImpl(const XCSP3Core::Node* node, const VariableMap& var_map) {
+ir::NodeId ConvertTreeImpl(const XCSP3Core::Node* node, ir::Model& model) {
     if (auto n = dynamic_cast<const XCSP3Core::NodeConstant*>(node)) {
-        int val = n->val;
-        return {std::to_string(val), Type::kInt};
+        return model.Const(n->val);
     }
     if (auto n = dynamic_cast<const XCSP3Core::NodeVariable*>(node)) {
         auto var_name = n->var;
-        if (auto found = var_map.find(var_name); found != var_map.end()) {
-            auto [converted_var_name, ty] = found->second;
-            return {converted_var_name, ty};
+        if (ir::VarId var = model.FindVariable(var_name); var >= 0) {
+            return model.Var(var);
         } else {
-            std::cerr << "error: unknown variable: " << var_name << std::endl;
-            abort();
+            throw std::runtime_error("unknown variable: " + var_name);
         }
     }
     if (auto n = dynamic_cast<const XCSP3Core::NodeOperator*>(node)) {
         if (n->type == ExpressionType::ODIST) {
             int n_arity = n->parameters.size();
             if (n_arity != 2) {
-                std::cerr << "error: n_arity must be 2 for dist" << std::endl;
-                abort();
+                throw std::runtime_error("n_arity must be 2 for dist");
             }
-            std::string ret_expr = "(abs (- ";
-            ret_expr += std::get<0>(AsInt(ConvertTreeImpl(n->parameters[0], var_map)));
-            ret_expr.push_back(' ');
-            ret_expr += std::get<0>(AsInt(ConvertTreeImpl(n->parameters[1], var_map)));
-            ret_expr += "))";
-            return {ret_expr, Type::kInt};
+            ir::NodeId lhs = model.AsInt(ConvertTreeImpl(n->parameters[0], model));
+            ir::NodeId rhs = model.AsInt(ConvertTreeImpl(n->parameters[1], model));
+            return model.Add(ir::Op::kAbs, ir::Type::kInt, {model.Add(ir::Op::kSub, ir::Type::kInt, {lhs, rhs})});
         }
         int n_arity = n->parameters.size();
-        auto [op_name, input_types, output_type] = OperatorInfo(n->type, n_arity);
+        auto [op, input_types, output_type] = OperatorInfo(n->type, n_arity);
 
-        std::string ret_expr = "(" + op_name;
+        std::vector<ir::NodeId> operands;
         for (int i = 0; i < n_arity; ++i) {
-            ret_expr.push_back(' ');
-            ret_expr += std::get<0>(AsType(ConvertTreeImpl(n->parameters[i], var_map), input_types[i]));
+            operands.push_back(model.AsType(ConvertTreeImpl(n->parameters[i], model), input_types[i]));
         }
-        ret_expr.push_back(')');
-        return {ret_expr, output_type};
+        return model.Add(op, output_type, operands);
     }
-    std::cerr << "error: unknown node" << std::endl;
-    abort();
+    throw std::runtime_error("unknown node");
 }
 
 }
 
-TypedConvertedExpr AsInt(const TypedConvertedExpr& ty_expr) {
-    auto [desc, ty] = ty_expr;
-    if (ty == Type::kBool) {
-        return {"(if " + desc + " 1 0)", Type::kInt};
-    } else {
-        return ty_expr;
-    }
-}
-
-TypedConvertedExpr AsBool(const TypedConvertedExpr& ty_expr) {
-    auto [desc, ty] = ty_expr;
-    if (ty == Type::kInt) {
-        return {"(> " + desc + " 0)", Type::kBool};
-    } else {
-        return ty_expr;
-    }
-}
-
-TypedConvertedExpr AsType(const TypedConvertedExpr& ty_expr, Type expected_type) {
-    if (expected_type == Type::kBool) {
-        return AsBool(ty_expr);
-    } else {
-        return AsInt(ty_expr);
-    }
-}
-
-TypedConvertedExpr ConvertTree(const XCSP3Core::Tree* tree, const VariableMap& var_map) {
-    return ConvertTreeImpl(tree->root, var_map);
+ir::NodeId ConvertTree(const XCSP3Core::Tree* tree, ir::Model& model) {
+    return ConvertTreeImpl(tree->root, model);
 }
@@ -1,12 +1,60 @@
+#include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <map>
+#include <string>
+#include <vector>
 
-#include <XCSP3Tree.h>
-#include "Converter.h"
+#include "Options.h"
+#include "XCSP3Converter.h"
+#include "Server.h"
+
+namespace {
+
+void PrintUsage(const char* prog) {
+    std::cerr << "usage: " << prog << " [options...] <input>" << std::endl;
+    std::cerr << "       " << prog << " --server [--workers <n>] [--socket <path>]" << std::endl;
+}
+
+}
 
 int main(int argc, char** argv) {
-    auto converted = ConvertXCSP3Instance(argv[1]);
-    if (converted.size() > 0 && converted.back() == '\n') converted.pop_back();
-    std::cout << converted << std::endl;
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (!args.empty() && args[0] == "--server") {
+        ServerOptions server_options;
+        for (int i = 1; i < args.size(); ++i) {
+            if (args[i] == "--workers" && i + 1 < args.size()) {
+                server_options.n_workers = std::atoi(args[++i].c_str());
+            } else if (args[i] == "--socket" && i + 1 < args.size()) {
+                server_options.socket_path = args[++i];
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        return RunServer(server_options);
+    }
+
+    if (args.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    std::string input = args.back();
+    args.pop_back();
+
+    ConverterOptions options;
+    std::string error;
+    if (!ParseConverterOptions(args, options, error)) {
+        std::cerr << "error: " << error << std::endl;
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    try {
+        ConvertXCSP3File(input, "-", options);
+    } catch (std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
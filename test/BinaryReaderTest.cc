@@ -0,0 +1,151 @@
+// Round trip of the binary format through PrintBinary and BinaryReader, and rejection of malformed files.
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BinaryReader.h"
+#include "Test.h"
+#include "XCSP3Converter.h"
+
+namespace {
+
+const char* kGoodPath = "binary_reader_test.bin";
+const char* kBadPath = "binary_reader_test_bad.bin";
+
+ir::Model BuildModel() {
+    ir::Model model;
+    ir::VarId x = model.AddVariable("x", ir::Type::kInt, 0, 5);
+    ir::VarId y = model.AddVariable("y[10]", ir::Type::kInt, -3, 7, {-3, 0, 7});
+    ir::VarId b = model.AddVariable("b", ir::Type::kBool, 0, 1);
+    // the first constraint is (== x 3), whose words are patched by the malformed cases below
+    model.AddConstraint(model.Add(ir::Op::kEq, ir::Type::kBool, {model.Var(x), model.Const(3)}));
+    ir::VarId aux = model.AddVariable("converter_aux_var_0", ir::Type::kInt, -100000, 100000, {}, true);
+    ir::NodeId sum = model.Add(ir::Op::kAdd, ir::Type::kInt, {model.Var(x), model.Add(ir::Op::kMul, ir::Type::kInt, {model.Const(-2), model.Var(y)})});
+    model.AddConstraint(model.Add(ir::Op::kLe, ir::Type::kBool, {sum, model.Var(aux)}));
+    model.AddConstraint(model.Add(ir::Op::kOr, ir::Type::kBool, {model.Var(b), model.Add(ir::Op::kNot, ir::Type::kBool, {model.BoolConst(false)})}));
+    model.AddConstraint(model.Add(ir::Op::kAllDifferent, ir::Type::kBool, {model.Var(x), model.Var(y), model.Const(-7)}));
+    return model;
+}
+
+bool SameNode(const ir::Model& model, ir::NodeId id, BinaryReader::NodeView view) {
+    const ir::Node& node = model.node(id);
+    if (view.op() != node.op || view.type() != node.type) return false;
+    if (node.op == ir::Op::kConst || node.op == ir::Op::kVar) return view.value() == node.value;
+    if (view.num_operands() != model.num_operands(id)) return false;
+    BinaryReader::NodeView operand = view.FirstOperand();
+    for (int i = 0; i < model.num_operands(id); ++i) {
+        if (!SameNode(model, model.operands(id)[i], operand)) return false;
+        operand = operand.Next();
+    }
+    return true;
+}
+
+void CheckSameAsModel(const BinaryReader& reader, const ir::Model& model) {
+    CHECK(reader.version() == binary_format::kVersion);
+    CHECK(reader.num_variables() == model.variables().size());
+    CHECK(reader.num_constraints() == model.constraints().size());
+
+    ir::VarId i = 0;
+    reader.ForEachVariable([&](BinaryReader::VariableView var) {
+        const ir::Variable& expected = model.variable(i);
+        CHECK(var.name() == OutputVariableName(model, i, ConverterOptions()));
+        CHECK(var.type() == expected.type);
+        CHECK(var.aux() == expected.aux);
+        CHECK(var.position() == expected.position);
+        CHECK(var.lo() == expected.lo);
+        CHECK(var.hi() == expected.hi);
+        CHECK(var.num_values() == expected.values.size());
+        for (int j = 0; j < var.num_values() && j < expected.values.size(); ++j) CHECK(var.value(j) == expected.values[j]);
+        ++i;
+    });
+
+    int c = 0;
+    reader.ForEachConstraint([&](BinaryReader::NodeView root) {
+        CHECK(SameNode(model, model.constraints()[c].root, root));
+        ++c;
+    });
+}
+
+void WriteFile(const char* path, const std::string& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(data.data(), data.size());
+}
+
+std::vector<int32_t> ToWords(const std::string& data) {
+    std::vector<int32_t> words(data.size() / sizeof(int32_t));
+    data.copy(reinterpret_cast<char*>(words.data()), words.size() * sizeof(int32_t));
+    return words;
+}
+
+std::string ToBytes(const std::vector<int32_t>& words) {
+    return std::string(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(int32_t));
+}
+
+// Returns whether `data` is accepted, checking that a rejected file leaves `reader` on the model
+bool Accepts(BinaryReader& reader, const ir::Model& model, const std::string& data) {
+    WriteFile(kBadPath, data);
+    std::string error;
+    bool opened = reader.Open(kBadPath, error);
+    if (!opened) {
+        CHECK(!error.empty());
+        CheckSameAsModel(reader, model);
+    }
+    return opened;
+}
+
+}
+
+void test::BinaryReaderTests() {
+    ir::Model model = BuildModel();
+    std::ostringstream out;
+    PrintBinary(model, ConverterOptions(), out);
+    std::string data = out.str();
+    WriteFile(kGoodPath, data);
+
+    BinaryReader reader;
+    std::string error;
+    CHECK(reader.Open(kGoodPath, error));
+    CheckSameAsModel(reader, model);
+
+    // the file is little-endian whatever the host
+    CHECK(data.size() > 8 * sizeof(int32_t));
+    CHECK(data[8] == 1 && data[9] == 0 && data[10] == 0 && data[11] == 0);
+
+    std::vector<int32_t> words = ToWords(data);
+    auto get = [&](const std::vector<int32_t>& w, size_t i) { return binary_format::LittleEndian(w[i]); };
+    auto patched = [&](size_t i, int32_t value) {
+        std::vector<int32_t> w = words;
+        w[i] = binary_format::LittleEndian(value);
+        return ToBytes(w);
+    };
+    // root of the first constraint (== x 3): [kEq | kBool << 8, 2, 4, kVar | kInt << 8, x, kConst | kInt << 8, 3]
+    size_t record = binary_format::kHeaderWords;
+    for (int i = 0; i < model.variables().size(); ++i) record += 1 + get(words, record);
+    size_t root = record + 1;
+    CHECK(get(words, root + 2) == 4);
+    CHECK(get(words, root + 4) == 0);
+
+    CHECK(!Accepts(reader, model, data.substr(0, data.size() - sizeof(int32_t))));
+    CHECK(!Accepts(reader, model, data.substr(0, 3 * sizeof(int32_t))));
+    CHECK(!Accepts(reader, model, patched(root + 2, 3)));
+    CHECK(!Accepts(reader, model, patched(root + 2, 5)));
+    CHECK(!Accepts(reader, model, patched(root + 2, -1)));
+    CHECK(!Accepts(reader, model, patched(root + 4, model.variables().size())));
+    CHECK(!Accepts(reader, model, patched(root + 4, -1)));
+    CHECK(!Accepts(reader, model, patched(binary_format::kHeaderWords, 2)));  // variable record too short for its fields
+    CHECK(!Accepts(reader, model, patched(binary_format::kHeaderWords + 7, 1000)));  // name longer than the record
+    CHECK(!Accepts(reader, model, patched(2, binary_format::kVersion + 1)));
+    CHECK(!reader.Open("binary_reader_test_missing.bin", error));
+    CheckSameAsModel(reader, model);
+
+    // a valid file replaces the current one
+    CHECK(Accepts(reader, model, data));
+    CheckSameAsModel(reader, model);
+
+    std::remove(kGoodPath);
+    std::remove(kBadPath);
+}
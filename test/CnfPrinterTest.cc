@@ -0,0 +1,412 @@
+// Checks the CNF backend against brute force: for random small models, every assignment of the
+// variables is fixed through the --cnf-map literals, and the CNF must be satisfiable exactly when the
+// assignment satisfies the model. Models found by the solver are decoded back through the map.
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Test.h"
+#include "XCSP3Converter.h"
+
+namespace {
+
+class ModelGenerator {
+public:
+    explicit ModelGenerator(unsigned seed) : rng_(seed) {}
+
+    ir::Model Generate() {
+        model_ = ir::Model();
+        ints_.clear();
+        bools_.clear();
+
+        int kind = Random(8);
+        bool circuit = kind == 0;
+        bool linear = kind == 1;  // a weighted sum over many variables, which is split into partial sums
+        int n_int = circuit || linear ? 4 + Random(2) : 1 + Random(3);
+        for (int i = 0; i < n_int; ++i) {
+            std::string name = "x" + std::to_string(i);
+            if (circuit) {
+                ints_.push_back(model_.AddVariable(name, ir::Type::kInt, -1, n_int));
+            } else if (linear) {
+                int lo = Random(5) - 2;
+                ints_.push_back(model_.AddVariable(name, ir::Type::kInt, lo, lo + 1));
+            } else if (Random(2)) {
+                int lo = Random(7) - 3;
+                ints_.push_back(model_.AddVariable(name, ir::Type::kInt, lo, lo + Random(4)));
+            } else {
+                std::set<int> values;
+                int n = 1 + Random(4);
+                for (int j = 0; j < n; ++j) values.insert(Random(11) - 5);
+                std::vector<int> sorted(values.begin(), values.end());
+                ints_.push_back(model_.AddVariable(name, ir::Type::kInt, sorted.front(), sorted.back(), sorted));
+            }
+        }
+        int n_bool = Random(3);
+        for (int i = 0; i < n_bool; ++i) {
+            int fixed = Random(5);  // some boolean variables are fixed to true or false
+            bools_.push_back(model_.AddVariable("b" + std::to_string(i), ir::Type::kBool, fixed == 0 ? 1 : 0, fixed == 1 ? 0 : 1));
+        }
+
+        int n_constraints = 1 + Random(2);
+        for (int i = 0; i < n_constraints; ++i) {
+            if (linear && i == 0) {
+                std::vector<ir::NodeId> terms;
+                for (auto var : ints_) terms.push_back(model_.Add(ir::Op::kMul, ir::Type::kInt, {model_.Const(Random(7) - 3), model_.Var(var)}));
+                ir::Op ops[] = {ir::Op::kLe, ir::Op::kGe, ir::Op::kEq, ir::Op::kNe};
+                ir::NodeId sum = model_.Add(ir::Op::kAdd, ir::Type::kInt, terms);
+                model_.AddConstraint(model_.Add(ops[Random(4)], ir::Type::kBool, {sum, model_.Const(Random(9) - 4)}));
+            } else if (circuit && i == 0) {
+                std::vector<ir::NodeId> operands;
+                for (auto var : ints_) operands.push_back(model_.Var(var));
+                model_.AddConstraint(model_.Add(ir::Op::kCircuit, ir::Type::kBool, operands));
+            } else if (Random(6) == 0) {
+                std::vector<ir::NodeId> operands;
+                int n = 2 + Random(2);
+                for (int j = 0; j < n; ++j) operands.push_back(IntExpr(1));
+                model_.AddConstraint(model_.Add(ir::Op::kAllDifferent, ir::Type::kBool, operands));
+            } else {
+                model_.AddConstraint(BoolExpr(3));
+            }
+        }
+        return std::move(model_);
+    }
+
+private:
+    int Random(int n) { return rng_() % n; }
+
+    std::vector<ir::NodeId> Operands(int n, int depth) {
+        std::vector<ir::NodeId> operands;
+        for (int i = 0; i < n; ++i) operands.push_back(IntExpr(depth));
+        return operands;
+    }
+
+    ir::NodeId IntExpr(int depth) {
+        switch (depth <= 0 ? Random(2) : Random(9)) {
+        case 0: return model_.Const(Random(7) - 3);
+        case 1: return model_.Var(ints_[Random(ints_.size())]);
+        case 2: return model_.Add(ir::Op::kNeg, ir::Type::kInt, {IntExpr(depth - 1)});
+        case 3: return model_.Add(ir::Op::kAdd, ir::Type::kInt, Operands(2 + Random(4), depth - 1));
+        case 4: return model_.Add(ir::Op::kSub, ir::Type::kInt, {IntExpr(depth - 1), IntExpr(depth - 1)});
+        case 5: return model_.Add(ir::Op::kMul, ir::Type::kInt, Operands(2 + Random(2), depth - 2));
+        case 6: return model_.Add(ir::Op::kIf, ir::Type::kInt, {BoolExpr(depth - 1), IntExpr(depth - 1), IntExpr(depth - 1)});
+        case 7: return model_.Add(ir::Op::kAbs, ir::Type::kInt, {IntExpr(depth - 1)});
+        default: return model_.AsInt(BoolExpr(depth - 1));
+        }
+    }
+
+    ir::NodeId BoolExpr(int depth) {
+        int kind = depth <= 0 ? Random(2) : Random(14);
+        switch (kind) {
+        case 0: return model_.BoolConst(Random(5) != 0);
+        case 1: return bools_.empty() ? model_.BoolConst(true) : model_.Var(bools_[Random(bools_.size())]);
+        case 2:
+        case 3: {
+            ir::Op ops[] = {ir::Op::kLe, ir::Op::kLt, ir::Op::kGe, ir::Op::kGt, ir::Op::kNe};
+            return model_.Add(ops[Random(5)], ir::Type::kBool, {IntExpr(depth - 1), IntExpr(depth - 1)});
+        }
+        case 4: return model_.Add(ir::Op::kEq, ir::Type::kBool, Operands(2 + Random(2), depth - 1));
+        case 5: return model_.Add(ir::Op::kNot, ir::Type::kBool, {BoolExpr(depth - 1)});
+        case 6:
+        case 7:
+        case 8:
+        case 9:
+        case 10: {
+            ir::Op ops[] = {ir::Op::kAnd, ir::Op::kOr, ir::Op::kImp, ir::Op::kIff, ir::Op::kXor};
+            ir::Op op = ops[kind - 6];
+            int n = op == ir::Op::kImp ? 2 : 1 + Random(3);
+            std::vector<ir::NodeId> operands;
+            for (int i = 0; i < n; ++i) operands.push_back(BoolExpr(depth - 1));
+            return model_.Add(op, ir::Type::kBool, operands);
+        }
+        default: return model_.AsBool(IntExpr(depth - 1));
+        }
+    }
+
+    std::mt19937 rng_;
+    ir::Model model_;
+    std::vector<ir::VarId> ints_, bools_;
+};
+
+int64_t Evaluate(const ir::Model& model, const std::vector<int>& assignment, ir::NodeId id) {
+    const ir::Node& node = model.node(id);
+    int n = model.num_operands(id);
+    const ir::NodeId* operands = model.operands(id);
+    auto eval = [&](int i) { return Evaluate(model, assignment, operands[i]); };
+    switch (node.op) {
+    case ir::Op::kConst: return node.value;
+    case ir::Op::kVar: return assignment[node.value];
+    case ir::Op::kNeg: return -eval(0);
+    case ir::Op::kAdd: {
+        int64_t sum = 0;
+        for (int i = 0; i < n; ++i) sum += eval(i);
+        return sum;
+    }
+    case ir::Op::kSub: return eval(0) - eval(1);
+    case ir::Op::kMul: {
+        int64_t product = 1;
+        for (int i = 0; i < n; ++i) product *= eval(i);
+        return product;
+    }
+    case ir::Op::kIf: return eval(0) ? eval(1) : eval(2);
+    case ir::Op::kAbs: return std::llabs(eval(0));
+    case ir::Op::kNot: return !eval(0);
+    case ir::Op::kAnd:
+        for (int i = 0; i < n; ++i) {
+            if (!eval(i)) return 0;
+        }
+        return 1;
+    case ir::Op::kOr:
+        for (int i = 0; i < n; ++i) {
+            if (eval(i)) return 1;
+        }
+        return 0;
+    case ir::Op::kXor: {
+        int parity = 0;
+        for (int i = 0; i < n; ++i) parity ^= eval(i) != 0;
+        return parity;
+    }
+    case ir::Op::kIff:
+    case ir::Op::kEq:
+        for (int i = 1; i < n; ++i) {
+            if (eval(i) != eval(0)) return 0;
+        }
+        return 1;
+    case ir::Op::kImp: return !eval(0) || eval(1);
+    case ir::Op::kNe: return eval(0) != eval(1);
+    case ir::Op::kLe: return eval(0) <= eval(1);
+    case ir::Op::kLt: return eval(0) < eval(1);
+    case ir::Op::kGe: return eval(0) >= eval(1);
+    case ir::Op::kGt: return eval(0) > eval(1);
+    case ir::Op::kAllDifferent: {
+        std::set<int64_t> seen;
+        for (int i = 0; i < n; ++i) {
+            if (!seen.insert(eval(i)).second) return 0;
+        }
+        return 1;
+    }
+    case ir::Op::kCircuit: {
+        // successors form a permutation with exactly one cycle of length >= 2; the other nodes loop on themselves
+        std::vector<int64_t> next;
+        for (int i = 0; i < n; ++i) next.push_back(eval(i));
+        for (auto v : next) {
+            if (v < 0 || v >= n) return 0;
+        }
+        if (std::set<int64_t>(next.begin(), next.end()).size() != n) return 0;
+        int start = -1, n_on_cycle = 0;
+        for (int i = 0; i < n; ++i) {
+            if (next[i] != i) {
+                start = i;
+                ++n_on_cycle;
+            }
+        }
+        if (start < 0) return 0;
+        int length = 0;
+        int64_t current = start;
+        do {
+            current = next[current];
+            ++length;
+        } while (current != start);
+        return length == n_on_cycle;
+    }
+    }
+    return 0;
+}
+
+struct Cnf {
+    int n_vars = 0;
+    std::vector<std::vector<int>> clauses;
+};
+
+// Solves by unit propagation and branching; `assignment[v]` is 1 (true), -1 (false) or 0 (free), and
+// holds a model on success
+bool Solve(const Cnf& cnf, std::vector<int>& assignment) {
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto& clause : cnf.clauses) {
+            int n_free = 0, free_lit = 0;
+            bool satisfied = false;
+            for (int lit : clause) {
+                int value = assignment[std::abs(lit)];
+                if (value == 0) {
+                    ++n_free;
+                    free_lit = lit;
+                } else if ((value > 0) == (lit > 0)) {
+                    satisfied = true;
+                    break;
+                }
+            }
+            if (satisfied) continue;
+            if (n_free == 0) return false;
+            if (n_free == 1) {
+                assignment[std::abs(free_lit)] = free_lit > 0 ? 1 : -1;
+                changed = true;
+            }
+        }
+    }
+    for (int v = 1; v <= cnf.n_vars; ++v) {
+        if (assignment[v] != 0) continue;
+        for (int value : {1, -1}) {
+            std::vector<int> branch = assignment;
+            branch[v] = value;
+            if (Solve(cnf, branch)) {
+                assignment = branch;
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+// A line of the --cnf-map output: for an int variable, the literals of x <= values[i] (the last value
+// has none); for a bool variable, a single literal
+struct MappedVariable {
+    bool is_bool = false;
+    std::vector<int> values;
+    std::vector<int> lits;
+};
+
+bool IsTrue(const std::vector<int>& assignment, int lit) {
+    return (assignment[std::abs(lit)] > 0) == (lit > 0);
+}
+
+void SetLit(std::vector<int>& assignment, int lit, bool value) {
+    assignment[std::abs(lit)] = (lit > 0) == value ? 1 : -1;
+}
+
+int Decode(const MappedVariable& var, const std::vector<int>& assignment) {
+    if (var.is_bool) return IsTrue(assignment, var.lits[0]) ? 1 : 0;
+    for (int i = 0; i < var.lits.size(); ++i) {
+        if (IsTrue(assignment, var.lits[i])) return var.values[i];
+    }
+    return var.values.back();
+}
+
+bool CheckModel(int seed, std::vector<int>& ops_seen) {
+    ir::Model model = ModelGenerator(seed).Generate();
+    for (auto& node : model.nodes()) ops_seen[(int)node.op] = 1;
+
+    ConverterOptions options;
+    std::ostringstream cnf_text, map_text, parallel_text;
+    PrintCnf(model, options, cnf_text, &map_text);
+    options.n_threads = 3;
+    PrintCnf(model, options, parallel_text);
+    CHECK(cnf_text.str() == parallel_text.str());
+
+    Cnf cnf;
+    std::istringstream cnf_in(cnf_text.str());
+    std::string p, format;
+    size_t n_clauses;
+    cnf_in >> p >> format >> cnf.n_vars >> n_clauses;
+    std::vector<int> clause;
+    for (int lit; cnf_in >> lit;) {
+        if (lit == 0) {
+            cnf.clauses.push_back(clause);
+            clause.clear();
+        } else {
+            clause.push_back(lit);
+        }
+    }
+    CHECK(cnf.clauses.size() == n_clauses);
+
+    std::vector<MappedVariable> mapped;
+    std::istringstream map_in(map_text.str());
+    for (std::string line; std::getline(map_in, line);) {
+        std::istringstream line_in(line);
+        std::string kind, name;
+        line_in >> kind >> name;
+        MappedVariable var;
+        var.is_bool = kind == "bool";
+        for (int word, i = 0; line_in >> word; ++i) {
+            // int: v_0 l_0 v_1 l_1 ... v_{k-1}
+            if (!var.is_bool && i % 2 == 0) {
+                var.values.push_back(word);
+            } else {
+                var.lits.push_back(word);
+            }
+        }
+        mapped.push_back(var);
+    }
+    const auto& variables = model.variables();
+    CHECK(mapped.size() == variables.size());
+    if (mapped.size() != variables.size()) return false;
+
+    // enumerate the domains, and both values of every bool variable, including the fixed ones
+    std::vector<std::vector<int>> domains, candidates;
+    for (auto& var : variables) {
+        std::vector<int> domain = var.values;
+        if (domain.empty()) {
+            for (int v = var.lo; v <= var.hi; ++v) domain.push_back(v);
+        }
+        domains.push_back(domain);
+        candidates.push_back(var.type == ir::Type::kBool ? std::vector<int>{0, 1} : domain);
+    }
+    auto is_solution = [&](const std::vector<int>& values) {
+        for (ir::VarId v = 0; v < variables.size(); ++v) {
+            if (std::find(domains[v].begin(), domains[v].end(), values[v]) == domains[v].end()) return false;
+        }
+        for (auto& constraint : model.constraints()) {
+            if (!Evaluate(model, values, constraint.root)) return false;
+        }
+        return true;
+    };
+
+    std::vector<int> index(variables.size(), 0), values(variables.size());
+    bool has_solution = false;
+    while (true) {
+        for (ir::VarId v = 0; v < variables.size(); ++v) values[v] = candidates[v][index[v]];
+        bool expected = is_solution(values);
+        has_solution |= expected;
+
+        std::vector<int> assignment(cnf.n_vars + 1, 0);
+        for (ir::VarId v = 0; v < variables.size(); ++v) {
+            if (mapped[v].is_bool) {
+                SetLit(assignment, mapped[v].lits[0], values[v] == 1);
+                continue;
+            }
+            for (int i = 0; i < mapped[v].lits.size(); ++i) SetLit(assignment, mapped[v].lits[i], values[v] <= mapped[v].values[i]);
+        }
+        bool satisfiable = Solve(cnf, assignment);
+        CHECK(satisfiable == expected);
+        if (satisfiable != expected) {
+            std::cerr << "seed " << seed << ":\n";
+            PrintSugar(model, ConverterOptions(), std::cerr);
+            return false;
+        }
+
+        ir::VarId v = 0;
+        for (; v < variables.size(); ++v) {
+            if (++index[v] < candidates[v].size()) break;
+            index[v] = 0;
+        }
+        if (v == variables.size()) break;
+    }
+
+    // without assumptions, the solver finds a model iff there is a solution, and the map decodes it to one
+    std::vector<int> assignment(cnf.n_vars + 1, 0);
+    bool satisfiable = Solve(cnf, assignment);
+    CHECK(satisfiable == has_solution);
+    if (satisfiable) {
+        for (ir::VarId v = 0; v < variables.size(); ++v) values[v] = Decode(mapped[v], assignment);
+        CHECK(is_solution(values));
+    }
+    return true;
+}
+
+}
+
+void test::CnfPrinterTests() {
+    std::vector<int> ops_seen((int)ir::Op::kCircuit + 1, 0);
+    for (int seed = 0; seed < 1000; ++seed) {
+        if (!CheckModel(seed, ops_seen)) break;
+    }
+    for (int op = 0; op < ops_seen.size(); ++op) {
+        if (!ops_seen[op]) std::cerr << "op " << op << " is not covered\n";
+        CHECK(ops_seen[op]);
+    }
+}
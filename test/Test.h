@@ -0,0 +1,21 @@
+#pragma once
+
+#include <iostream>
+
+// Failed checks are reported with their location and counted; the test binary fails if any check failed.
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond "\n";   \
+            ++test::failures;                                                            \
+        }                                                                                \
+    } while (0)
+
+namespace test {
+
+extern int failures;
+
+void CnfPrinterTests();
+void BinaryReaderTests();
+
+}
@@ -0,0 +1,14 @@
+#include "Test.h"
+
+int test::failures = 0;
+
+int main() {
+    test::CnfPrinterTests();
+    test::BinaryReaderTests();
+    if (test::failures > 0) {
+        std::cerr << test::failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cerr << "all tests passed\n";
+    return 0;
+}